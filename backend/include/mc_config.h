@@ -9,15 +9,20 @@
 #define MC_MAX_SYMBOLS   32
 #define MC_MAX_TAB_NAME  32
 #define MC_MAX_TABS      10
+#define MC_MAX_RATE_LIMITS 32
+#define MC_MAX_HOST      128
 
 typedef struct {
     char          name[MC_MAX_SOURCE];
     char          url[MC_MAX_URL];
     mc_category_t category;
     int           refresh_interval_sec;
+    int           refresh_min_sec;   /* Adaptive bounds; equal = fixed */
+    int           refresh_max_sec;
     int           tier;              /* 1=high, 2=mid, 3=low (default) */
     char          region[MC_MAX_REGION];
     char          country[MC_MAX_COUNTRY];
+    int           compression;       /* Negotiate gzip etc. (default on) */
 } mc_rss_source_cfg_t;
 
 typedef struct {
@@ -32,6 +37,8 @@ typedef struct {
     char          symbols[MC_MAX_SYMBOLS][MC_MAX_SYMBOL];
     int           symbol_count;
     int           refresh_interval_sec;
+    int           refresh_min_sec;      /* Adaptive bounds; equal = fixed */
+    int           refresh_max_sec;
     char          response_format[32];  /* json_object, json_array */
 
     /* Generic field mapping (JSONPath-like, simple dot notation) */
@@ -44,6 +51,7 @@ typedef struct {
     char          data_path[64];        /* e.g. "data.items" - path to array */
     char          post_body[MC_MAX_PARAMS]; /* JSON body for POST requests */
     char          currency[MC_MAX_SYMBOL]; /* base currency for forex, e.g. "USD" */
+    int           compression;          /* Negotiate gzip etc. (default on) */
 } mc_rest_source_cfg_t;
 
 typedef struct {
@@ -54,12 +62,25 @@ typedef struct {
     int           reconnect_interval_sec;
 } mc_ws_source_cfg_t;
 
+/* Request budget for one host, overriding [general] host_rate_per_sec */
+typedef struct {
+    char          host[MC_MAX_HOST];
+    double        per_sec;
+    double        burst;
+} mc_rate_limit_cfg_t;
+
 typedef struct {
     /* General */
     int  refresh_interval_sec;
     char db_path[MC_MAX_PATH];
     char log_level[16];
     int  max_items_per_source;
+    int  tick_heartbeat_sec;  /* Re-store an unchanged quote this often; 0 = every tick */
+    char storage[16];         /* "disk", or "memory" with periodic checkpoints */
+    int  checkpoint_interval_sec;
+    int  rss_workers;         /* Feeds fetched concurrently (requests in flight) */
+    double host_rate_per_sec; /* Requests per second to any one host; 0 = no limit */
+    double host_burst;        /* Requests a host may get back to back */
 
     /* API */
     int  http_port;
@@ -78,6 +99,10 @@ typedef struct {
     int                  rest_count;
     mc_ws_source_cfg_t   ws_sources[MC_MAX_SOURCES];
     int                  ws_count;
+
+    /* Per-host request budgets */
+    mc_rate_limit_cfg_t  rate_limits[MC_MAX_RATE_LIMITS];
+    int                  rate_limit_count;
 } mc_config_t;
 
 int  mc_config_load(const char *path, mc_config_t *cfg);
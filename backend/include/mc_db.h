@@ -2,33 +2,173 @@
 #define MC_DB_H
 
 #include "mc_models.h"
+#include "mc_summary.h"
 #include "mc_error.h"
 
 typedef struct mc_db mc_db_t;
 
 mc_db_t    *mc_db_open(const char *path);
+
+/* Keep the database in memory, loaded from path if it exists, and copy
+   it back to path every checkpoint_sec and on close. A crash loses at
+   most one interval of writes. */
+mc_db_t    *mc_db_open_memory(const char *path, int checkpoint_sec);
 void        mc_db_close(mc_db_t *db);
 mc_error_t  mc_db_migrate(mc_db_t *db);
 
 mc_error_t  mc_db_insert_entry(mc_db_t *db, const mc_data_entry_t *entry);
 mc_error_t  mc_db_insert_news(mc_db_t *db, const mc_news_item_t *item);
 
+/* Write a whole fetch result in one transaction (one lock, one commit) */
+mc_error_t  mc_db_insert_entries_batch(mc_db_t *db,
+                                       const mc_data_entry_t *entries, int count);
+mc_error_t  mc_db_insert_news_batch(mc_db_t *db,
+                                    const mc_news_item_t *items, int count);
+
+/* Inserts and source status updates are queued to a dedicated writer
+   thread (started by mc_db_migrate) and committed in group transactions.
+   The hook runs on the writer thread after every commit that wrote rows. */
+typedef void (*mc_db_commit_hook_fn)(void *ctx);
+void mc_db_set_commit_hook(mc_db_t *db, mc_db_commit_hook_fn fn, void *ctx);
+
+typedef struct {
+    int      queue_depth;     /* jobs waiting for the writer */
+    int      queue_capacity;
+    uint64_t enqueued;        /* jobs accepted since start */
+    uint64_t dropped;         /* jobs rejected because the queue was full */
+    uint64_t skipped;         /* entries not queued because the quote was unchanged */
+    uint64_t commits;         /* group transactions */
+    uint64_t rows_written;
+    double   last_commit_ms;
+    double   avg_commit_ms;
+    double   max_commit_ms;
+} mc_db_writer_stats_t;
+
+void mc_db_get_writer_stats(mc_db_t *db, mc_db_writer_stats_t *out);
+
+typedef struct {
+    int      in_memory;       /* Other fields are zero when 0 */
+    int      interval_sec;
+    uint64_t checkpoints;     /* Successful copies to disk */
+    uint64_t failures;
+    time_t   last_at;
+    double   last_ms;         /* Whole checkpoint, including the fsync */
+    double   last_copy_ms;    /* Part that held off commits */
+    uint64_t last_bytes;
+} mc_db_checkpoint_stats_t;
+
+void mc_db_get_checkpoint_stats(mc_db_t *db, mc_db_checkpoint_stats_t *out);
+
+/* Maintenance, run off the ingest path on a connection of its own, from
+   one thread at a time (the scheduler's maintenance thread). Commits no
+   longer checkpoint the WAL themselves unless it grows far past what
+   MC_DB_MAINT_CHECKPOINT keeps up with. */
+typedef enum {
+    MC_DB_MAINT_CHECKPOINT,   /* PASSIVE: copy what it can, never waits */
+    MC_DB_MAINT_TRUNCATE,     /* Waits for the writer, then empties the WAL */
+    MC_DB_MAINT_OPTIMIZE,     /* PRAGMA optimize */
+    MC_DB_MAINT_VACUUM,       /* Incremental vacuum of pages freed by pruning */
+    MC_DB_MAINT_COUNT
+} mc_db_maint_task_t;
+
+mc_error_t  mc_db_maintain(mc_db_t *db, mc_db_maint_task_t task);
+const char *mc_db_maint_task_str(mc_db_maint_task_t task);
+
+typedef struct {
+    uint64_t runs;
+    uint64_t failures;        /* Errors, or checkpoints that hit a busy lock */
+    time_t   last_at;
+    double   last_ms;
+    double   avg_ms;
+    double   max_ms;
+} mc_db_maint_task_stats_t;
+
+typedef struct {
+    mc_db_maint_task_stats_t tasks[MC_DB_MAINT_COUNT];
+    int      wal_frames;      /* WAL size after the last checkpoint... */
+    int      wal_backfilled;  /* ...and how much of it reached the database */
+    int      freelist_pages;  /* Free pages left after the last vacuum */
+    uint64_t pages_vacuumed;  /* Returned to the filesystem since start */
+} mc_db_maint_stats_t;
+
+void mc_db_get_maint_stats(mc_db_t *db, mc_db_maint_stats_t *out);
+
+/* Change-only ingest: an entry whose value, change and volume match the
+   last one stored for its (source, symbol) is dropped unless heartbeat_sec
+   has passed since. 0 stores every entry; that is the default until this
+   is called, while the scheduler applies tick_heartbeat_sec (300 unless
+   configured). */
+void mc_db_set_tick_heartbeat(mc_db_t *db, int heartbeat_sec);
+
+typedef struct {
+    char     source_name[MC_MAX_SOURCE];
+    uint64_t received;        /* entries handed to mc_db_insert_entries_batch */
+    uint64_t stored;          /* of those, queued for the writer */
+} mc_db_ingest_stats_t;
+
+int mc_db_get_ingest_stats(mc_db_t *db, mc_db_ingest_stats_t *out, int max_count);
+
 int mc_db_get_latest_entries(mc_db_t *db, mc_category_t cat,
                              mc_data_entry_t *out, int max_count);
 int mc_db_get_latest_news(mc_db_t *db, mc_category_t cat,
                           mc_news_item_t *out, int max_count);
 int mc_db_get_all_latest_news(mc_db_t *db,
                                mc_news_item_t *out, int max_count);
+/* Same rows with summaries left packed; release with mc_news_rec_free() */
+int mc_db_get_all_latest_news_recs(mc_db_t *db,
+                                   mc_news_rec_t *out, int max_count);
+/* Full-text search over title, summary and source; every word must
+   match ("infla*" for prefixes). Best match first, weighted by base_score. */
+int mc_db_search_news(mc_db_t *db, const char *query,
+                      mc_news_item_t *out, int max_count);
 int mc_db_get_entry_history(mc_db_t *db, const char *symbol,
                             mc_data_entry_t *out, int max_count);
 
+/* OHLCV candles rolled up at ingest, one series per (symbol, source) */
+typedef struct {
+    char   source_name[MC_MAX_SOURCE];
+    time_t bucket;       /* Interval start */
+    double open;
+    double high;
+    double low;
+    double close;
+    double volume;       /* Last volume reported in the interval */
+    int    ticks;
+} mc_candle_t;
+
+/* "1m", "5m", "1h", "1d" -> seconds; 0 if unsupported */
+int mc_db_candle_res_parse(const char *s);
+
+/* Candles with bucket in [from, to], oldest first. If more than max_count
+   match, the newest are kept. source may be NULL for every source. */
+int mc_db_get_candles(mc_db_t *db, const char *symbol, int res_sec,
+                      const char *source, time_t from, time_t to,
+                      mc_candle_t *out, int max_count);
+
 mc_error_t mc_db_update_source_status(mc_db_t *db, const char *source_name,
                                       mc_source_type_t type, const char *error);
 mc_error_t mc_db_prune_old(mc_db_t *db, int max_age_sec);
 
+/* Mark a source's stored rows (news items if news, else latest entries)
+   as fetched now, so a source whose server answers "not modified" is not
+   aged out by mc_db_prune_old */
+mc_error_t mc_db_touch_source(mc_db_t *db, const char *source_name, int news);
+
+/* Row counts are kept in memory by the writer and pruning, seeded once by
+   mc_db_migrate(); none of these touch SQLite */
 int mc_db_count_entries(mc_db_t *db);
 int mc_db_count_news(mc_db_t *db);
 
+typedef struct {
+    char          source_name[MC_MAX_SOURCE];
+    mc_category_t category;
+    int64_t       rows;
+} mc_db_row_count_t;
+
+/* One row per (source, category) of entry history, or of news if news
+   is set. Returns the number of groups written. */
+int mc_db_get_row_counts(mc_db_t *db, int news, mc_db_row_count_t *out, int max_count);
+
 /* Source status info */
 typedef struct {
     char             source_name[MC_MAX_SOURCE];
@@ -2,14 +2,17 @@
 #define MC_FETCH_REST_H
 
 #include "mc_config.h"
+#include "mc_http.h"
 #include "mc_models.h"
 
-int mc_fetch_rest(const mc_rest_source_cfg_t *cfg,
-                  mc_data_entry_t *entries_out,
-                  int max_entries);
+/* Fetches go through mc_http: build the request, then parse the body
+   the engine hands back */
+void mc_fetch_rest_request(const mc_rest_source_cfg_t *cfg, mc_http_request_t *req);
 
-int mc_fetch_rest_calendar(const mc_rest_source_cfg_t *cfg,
-                           mc_news_item_t *news_out,
-                           int max_items);
+int mc_fetch_rest_parse(const mc_rest_source_cfg_t *cfg, const char *body,
+                        mc_data_entry_t *entries_out, int max_entries);
+
+int mc_fetch_rest_calendar_parse(const mc_rest_source_cfg_t *cfg, const char *body,
+                                 mc_news_item_t *news_out, int max_items);
 
 #endif
@@ -2,10 +2,14 @@
 #define MC_FETCH_RSS_H
 
 #include "mc_config.h"
+#include "mc_http.h"
 #include "mc_models.h"
 
-int mc_fetch_rss(const mc_rss_source_cfg_t *cfg,
-                 mc_news_item_t *items_out,
-                 int max_items);
+#include <stddef.h>
+
+void mc_fetch_rss_request(const mc_rss_source_cfg_t *cfg, mc_http_request_t *req);
+
+int mc_fetch_rss_parse(const mc_rss_source_cfg_t *cfg, const char *body, size_t size,
+                       mc_news_item_t *items_out, int max_items);
 
 #endif
@@ -0,0 +1,96 @@
+#ifndef MC_HTTP_H
+#define MC_HTTP_H
+
+#include "mc_error.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Async HTTP engine: one thread drives every transfer through
+   curl_multi_socket_action and epoll, so the number of requests in flight
+   is not tied to the number of threads. */
+typedef struct mc_http mc_http_t;
+
+#define MC_HTTP_MAX_HEADERS 8
+#define MC_HTTP_MAX_VALIDATOR 128  /* ETag / Last-Modified value */
+
+/* Strings are copied on submit, so a request can live on the stack */
+typedef struct {
+    char        url[1024];
+    char        headers[MC_HTTP_MAX_HEADERS][256];
+    int         header_count;
+    const char *post_body;        /* NULL for GET */
+    int         follow_location;
+    long        timeout_sec;
+    int         identity_encoding; /* Don't offer gzip/deflate/br/zstd */
+    const char *user_agent;       /* NULL for the default */
+} mc_http_request_t;
+
+typedef struct {
+    mc_error_t  err;              /* MC_OK once a response was received,
+                                     MC_ERR_RATE_LIMIT if the host asked
+                                     us to back off */
+    long        status;           /* HTTP status, 0 if none */
+    char        error[256];       /* Transfer error text when err != MC_OK */
+    char       *body;             /* NUL-terminated; owned by the callback */
+    size_t      size;             /* Decoded body */
+    size_t      wire_size;        /* Body as received, before decoding */
+    char        etag[MC_HTTP_MAX_VALIDATOR];           /* "" if not sent */
+    char        last_modified[MC_HTTP_MAX_VALIDATOR];
+    int         retry_after_sec;  /* With MC_ERR_RATE_LIMIT */
+} mc_http_response_t;
+
+/* Runs on the engine thread: hand the response off and return quickly.
+   Also called with MC_ERR_HTTP for transfers still in flight when the
+   engine is destroyed. */
+typedef void (*mc_http_done_fn)(void *ctx, mc_http_response_t *resp);
+
+mc_http_t *mc_http_create(void);
+void       mc_http_destroy(mc_http_t *http);
+
+mc_error_t mc_http_submit(mc_http_t *http, const mc_http_request_t *req,
+                          mc_http_done_fn done, void *ctx);
+
+/* Append "Name: value" to req; ignored past MC_HTTP_MAX_HEADERS */
+void       mc_http_add_header(mc_http_request_t *req, const char *header);
+
+int        mc_http_in_flight(mc_http_t *http);
+
+/* Per-host request budget: a token bucket refilled at per_sec up to
+   burst tokens, shared by every request to that host. Requests over
+   budget wait in the engine, in submission order. host NULL sets the
+   budget of hosts not configured by name; per_sec <= 0 means unlimited,
+   the default.
+
+   A 429, or a 503 with Retry-After, pauses the host for the Retry-After
+   delay: requests to it then complete at once with MC_ERR_RATE_LIMIT and
+   the seconds left, without being sent. */
+void       mc_http_set_rate_limit(mc_http_t *http, const char *host,
+                                  double per_sec, double burst);
+
+/* Per-host transfer timings and rate limiting. Handshake averages cover
+   only requests that opened a new connection; the rest reused a pooled
+   one. */
+#define MC_HTTP_MAX_HOSTS 128
+#define MC_HTTP_MAX_HOST  128
+
+typedef struct {
+    char     host[MC_HTTP_MAX_HOST];
+    uint64_t requests;
+    uint64_t failures;
+    uint64_t new_connections;
+    uint64_t reused;
+    double   avg_connect_ms;      /* Until TCP connected, DNS included */
+    double   avg_appconnect_ms;   /* Until TLS done; 0 for plain HTTP */
+    double   avg_total_ms;
+    uint64_t throttled;           /* Requests that waited for a token */
+    int      queued;              /* Waiting now */
+    uint64_t rate_limited;        /* 429 / 503 Retry-After answers */
+    uint64_t refused;             /* Failed unsent during a pause */
+    int      paused_sec;          /* Retry-After left, 0 if none */
+} mc_http_host_stats_t;
+
+int        mc_http_get_host_stats(mc_http_t *http, mc_http_host_stats_t *out,
+                                  int max_count);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef MC_INTERN_H
+#define MC_INTERN_H
+
+#include "mc_models.h"
+
+#include <stdint.h>
+
+/* Process-wide string dictionary: symbols, source names, display names
+   and currencies map to dense 32-bit ids. Append-only, so a resolved
+   string stays valid until mc_intern_shutdown(). Id 0 is "". */
+uint32_t    mc_intern(const char *s);
+const char *mc_intern_str(uint32_t id);
+uint32_t    mc_intern_count(void);  /* One past the highest id */
+
+/* Register a string under a known id (restoring a persisted dictionary).
+   Returns 0 if the slot was free or already held the same string. */
+int         mc_intern_restore(uint32_t id, const char *s);
+
+void        mc_intern_shutdown(void);
+
+/* mc_data_entry_t with its strings interned (72 bytes instead of 360) */
+typedef struct {
+    int64_t          id;
+    uint32_t         source_id;
+    uint32_t         symbol_id;
+    uint32_t         display_id;
+    uint32_t         currency_id;
+    mc_source_type_t source_type;
+    mc_category_t    category;
+    double           value;
+    double           change_pct;
+    double           volume;
+    time_t           timestamp;
+    time_t           fetched_at;
+} mc_entry_rec_t;
+
+void mc_entry_pack(const mc_data_entry_t *e, mc_entry_rec_t *out);
+void mc_entry_unpack(const mc_entry_rec_t *r, mc_data_entry_t *out);
+
+#endif
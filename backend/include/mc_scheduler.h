@@ -3,6 +3,8 @@
 
 #include "mc_config.h"
 #include "mc_db.h"
+#include "mc_http.h"
+#include "mc_intern.h"
 #include "mc_models.h"
 
 typedef struct mc_scheduler mc_scheduler_t;
@@ -13,10 +15,50 @@ void            mc_scheduler_stop(mc_scheduler_t *sched);
 void            mc_scheduler_destroy(mc_scheduler_t *sched);
 void            mc_scheduler_force_refresh(mc_scheduler_t *sched);
 
-/* Thread-safe snapshot access for API layer */
+/* Thread-safe snapshot access for API layer. Entries are kept interned;
+   resolve them with mc_entry_unpack() when serializing. */
 int mc_scheduler_get_entries(mc_scheduler_t *sched,
-                             mc_data_entry_t *out, int max_count);
+                             mc_entry_rec_t *out, int max_count);
+/* Summaries are kept packed in the snapshot and only unpacked on request */
 int mc_scheduler_get_news(mc_scheduler_t *sched,
-                          mc_news_item_t *out, int max_count);
+                          mc_news_item_t *out, int max_count, int with_summary);
+
+/* When the snapshot was built (0 if never). *warm is set while it is
+   still the previous run's copy, loaded from <db_path>.snapshot. */
+time_t mc_scheduler_snapshot_time(mc_scheduler_t *sched, int *warm);
+
+/* Polled sources: how long after its deadline each fetch started, how
+   many fetches the server answered 304 Not Modified, how well bodies
+   compressed in transit, the current (possibly adapted) interval, and
+   how often the host rate limited it. Sources not fetched yet are left
+   out. */
+typedef struct {
+    char             source_name[MC_MAX_SOURCE];
+    mc_source_type_t source_type;
+    uint64_t         fetches;
+    int64_t          delay_last_ms;
+    double           delay_avg_ms;
+    int64_t          delay_max_ms;
+    uint64_t         not_modified;
+    uint64_t         bytes_saved;    /* Size of the cached body, per 304 */
+    uint64_t         bytes_wire;     /* Body bytes received */
+    uint64_t         bytes_decoded;  /* Same bodies after decoding */
+    int              interval_sec;   /* Poll interval now in use */
+    uint64_t         changes;        /* Fetches that brought new content */
+    uint64_t         rate_limited;   /* 429s, and fetches refused after one */
+    int              retry_in_sec;   /* Retry-After left, 0 if not limited */
+} mc_sched_source_stats_t;
+
+int mc_scheduler_get_source_stats(mc_scheduler_t *sched,
+                                  mc_sched_source_stats_t *out, int max_count);
+
+/* Seconds from start until every RSS feed had been fetched once, or -1
+   while some are still pending */
+double mc_scheduler_rss_first_pass(mc_scheduler_t *sched);
+
+/* RSS/REST transfers in flight and per-host timings (0 hosts if the
+   engine is not running) */
+int mc_scheduler_get_http_stats(mc_scheduler_t *sched, int *in_flight,
+                                mc_http_host_stats_t *out, int max_count);
 
 #endif
@@ -0,0 +1,25 @@
+#ifndef MC_SNAPSHOT_H
+#define MC_SNAPSHOT_H
+
+#include "mc_error.h"
+#include "mc_intern.h"
+#include "mc_summary.h"
+
+#include <time.h>
+
+/* Warm-start file: the scheduler's last entries/news snapshot, so a
+   restart can serve it before the first fetch completes. Interned ids
+   are stored with their strings and summaries stay packed. The file is
+   a local cache in native byte order; a CRC guards against torn writes. */
+mc_error_t mc_snapshot_save(const char *path, time_t built_at,
+                            const mc_entry_rec_t *entries, int entry_count,
+                            const mc_news_rec_t *news, int news_count);
+
+/* Maps path and copies its records out, re-interning strings and
+   allocating summaries (free with mc_news_rec_free). Returns
+   MC_ERR_NOT_FOUND if there is no file, MC_ERR_PARSE if it is invalid. */
+mc_error_t mc_snapshot_load(const char *path, time_t *built_at,
+                            mc_entry_rec_t *entries, int *entry_count, int max_entries,
+                            mc_news_rec_t *news, int *news_count, int max_news);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef MC_SUMMARY_H
+#define MC_SUMMARY_H
+
+#include "mc_models.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Packed news summary: a format byte, then either the raw text or raw
+   deflate primed with a built-in dictionary of newswire phrasing.
+   An empty summary packs to zero bytes. */
+#define MC_SUMMARY_PACK_MAX (MC_MAX_SUMMARY + 16)
+
+size_t mc_summary_pack(const char *text, unsigned char *out, size_t cap);
+
+/* Writes a NUL-terminated summary to out. Returns 0, or -1 if the input
+   is corrupt or does not fit (out is then ""). */
+int    mc_summary_unpack(const void *packed, size_t len, char *out, size_t cap);
+
+/* mc_news_item_t with its summary left packed (1 KB instead of 4 KB) */
+typedef struct {
+    int64_t        id;
+    char           title[MC_MAX_TITLE];
+    char           source[MC_MAX_SOURCE];
+    char           url[MC_MAX_URL];
+    mc_category_t  category;
+    time_t         published_at;
+    time_t         fetched_at;
+    double         score;
+    char           region[MC_MAX_REGION];
+    char           country[MC_MAX_COUNTRY];
+    unsigned char *summary;      /* malloc'd, NULL when empty */
+    uint32_t       summary_len;
+} mc_news_rec_t;
+
+void mc_news_rec_unpack(const mc_news_rec_t *r, mc_news_item_t *out,
+                        int with_summary);
+void mc_news_rec_free(mc_news_rec_t *recs, int count);
+
+#endif
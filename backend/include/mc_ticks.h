@@ -0,0 +1,25 @@
+#ifndef MC_TICKS_H
+#define MC_TICKS_H
+
+#include "mc_models.h"
+#include "mc_error.h"
+
+/* Append-only price history: one series per (source, symbol), stored as
+   fixed-width records in memory-mapped segment files under one directory.
+   A single thread appends; any number of threads may read. */
+typedef struct mc_ticks mc_ticks_t;
+
+mc_ticks_t *mc_ticks_open(const char *dir);
+void        mc_ticks_close(mc_ticks_t *ts);
+
+mc_error_t  mc_ticks_append(mc_ticks_t *ts, const mc_data_entry_t *e);
+
+/* Newest first, merged across every source quoting the symbol */
+int         mc_ticks_history(mc_ticks_t *ts, const char *symbol,
+                             mc_data_entry_t *out, int max_count);
+
+/* Drop whole segments whose newest tick is older than cutoff.
+   Returns the number of segments removed. */
+int         mc_ticks_prune(mc_ticks_t *ts, time_t cutoff);
+
+#endif
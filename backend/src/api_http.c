@@ -8,6 +8,11 @@
 #include <stdlib.h>
 #include <time.h>
 
+#define HTTP_THREAD_POOL_SIZE 4  /* Each thread queries through its own DB reader */
+#define HTTP_MAX_CANDLES      1000
+#define HTTP_MAX_SEARCH       200
+#define HTTP_MAX_ROW_COUNTS   4096 /* (source, category) groups in status */
+
 struct mc_api_http {
     struct MHD_Daemon *daemon;
     mc_scheduler_t    *sched;
@@ -33,14 +38,15 @@ static cJSON *entry_to_json(const mc_data_entry_t *e)
     return obj;
 }
 
-static cJSON *news_to_json(const mc_news_item_t *n)
+static cJSON *news_to_json(const mc_news_item_t *n, int with_summary)
 {
     cJSON *obj = cJSON_CreateObject();
     cJSON_AddNumberToObject(obj, "id", (double)n->id);
     cJSON_AddStringToObject(obj, "title", n->title);
     cJSON_AddStringToObject(obj, "source", n->source);
     cJSON_AddStringToObject(obj, "url", n->url);
-    cJSON_AddStringToObject(obj, "summary", n->summary);
+    if (with_summary)
+        cJSON_AddStringToObject(obj, "summary", n->summary);
     cJSON_AddStringToObject(obj, "category", mc_category_str(n->category));
     cJSON_AddNumberToObject(obj, "published_at", (double)n->published_at);
     cJSON_AddNumberToObject(obj, "fetched_at", (double)n->fetched_at);
@@ -50,6 +56,32 @@ static cJSON *news_to_json(const mc_news_item_t *n)
     return obj;
 }
 
+/* Entry or news row counts keyed by category and by source */
+static cJSON *row_counts_to_json(mc_db_t *db, int news)
+{
+    cJSON *obj = cJSON_CreateObject();
+    cJSON *by_cat = cJSON_AddObjectToObject(obj, "by_category");
+    cJSON *by_src = cJSON_AddObjectToObject(obj, "by_source");
+    mc_db_row_count_t *counts = malloc(HTTP_MAX_ROW_COUNTS * sizeof(*counts));
+    if (!counts) return obj;
+
+    int n = mc_db_get_row_counts(db, news, counts, HTTP_MAX_ROW_COUNTS);
+    for (int i = 0; i < n; i++) {
+        cJSON *groups[2] = { by_cat, by_src };
+        const char *keys[2] = { mc_category_str(counts[i].category),
+                                counts[i].source_name };
+        for (int k = 0; k < 2; k++) {
+            cJSON *item = cJSON_GetObjectItemCaseSensitive(groups[k], keys[k]);
+            if (item)
+                cJSON_SetNumberValue(item, item->valuedouble + (double)counts[i].rows);
+            else
+                cJSON_AddNumberToObject(groups[k], keys[k], (double)counts[i].rows);
+        }
+    }
+    free(counts);
+    return obj;
+}
+
 static enum MHD_Result send_json(struct MHD_Connection *conn, int status, cJSON *json)
 {
     char *body = cJSON_PrintUnformatted(json);
@@ -66,10 +98,20 @@ static enum MHD_Result send_json(struct MHD_Connection *conn, int status, cJSON
     return ret;
 }
 
+/* Until the first rebuild after a restart the snapshot is the previous
+   run's warm-start copy; clients can tell from "stale" */
+static void add_snapshot_age(mc_api_http_t *api, cJSON *root)
+{
+    int warm = 0;
+    time_t built_at = mc_scheduler_snapshot_time(api->sched, &warm);
+    cJSON_AddNumberToObject(root, "as_of", (double)built_at);
+    cJSON_AddBoolToObject(root, "stale", warm);
+}
+
 static enum MHD_Result handle_entries(mc_api_http_t *api,
                                        struct MHD_Connection *conn)
 {
-    mc_data_entry_t *entries = malloc(2048 * sizeof(mc_data_entry_t));
+    mc_entry_rec_t *entries = malloc(2048 * sizeof(mc_entry_rec_t));
     if (!entries) return MHD_NO;
     int n = mc_scheduler_get_entries(api->sched, entries, 2048);
 
@@ -83,9 +125,11 @@ static enum MHD_Result handle_entries(mc_api_http_t *api,
     for (int i = 0; i < n; i++) {
         if (cat_filter && strcmp(mc_category_str(entries[i].category), cat_filter) != 0)
             continue;
-        if (sym_filter && strstr(entries[i].symbol, sym_filter) == NULL)
+        if (sym_filter && strstr(mc_intern_str(entries[i].symbol_id), sym_filter) == NULL)
             continue;
-        cJSON_AddItemToArray(arr, entry_to_json(&entries[i]));
+        mc_data_entry_t e;
+        mc_entry_unpack(&entries[i], &e);
+        cJSON_AddItemToArray(arr, entry_to_json(&e));
     }
 
     free(entries);
@@ -93,6 +137,7 @@ static enum MHD_Result handle_entries(mc_api_http_t *api,
     cJSON *root = cJSON_CreateObject();
     cJSON_AddItemToObject(root, "data", arr);
     cJSON_AddNumberToObject(root, "count", cJSON_GetArraySize(arr));
+    add_snapshot_age(api, root);
 
     return send_json(conn, MHD_HTTP_OK, root);
 }
@@ -102,7 +147,12 @@ static enum MHD_Result handle_news(mc_api_http_t *api,
 {
     mc_news_item_t *news = malloc(2048 * sizeof(mc_news_item_t));
     if (!news) return MHD_NO;
-    int n = mc_scheduler_get_news(api->sched, news, 2048);
+
+    /* ?summary=0 skips unpacking summaries for list views */
+    const char *summary_arg = MHD_lookup_connection_value(
+        conn, MHD_GET_ARGUMENT_KIND, "summary");
+    int with_summary = !(summary_arg && strcmp(summary_arg, "0") == 0);
+    int n = mc_scheduler_get_news(api->sched, news, 2048, with_summary);
 
     const char *cat_filter = MHD_lookup_connection_value(
         conn, MHD_GET_ARGUMENT_KIND, "category");
@@ -119,7 +169,7 @@ static enum MHD_Result handle_news(mc_api_http_t *api,
             continue;
         if (country_filter && strcmp(news[i].country, country_filter) != 0)
             continue;
-        cJSON_AddItemToArray(arr, news_to_json(&news[i]));
+        cJSON_AddItemToArray(arr, news_to_json(&news[i], with_summary));
     }
 
     free(news);
@@ -127,6 +177,42 @@ static enum MHD_Result handle_news(mc_api_http_t *api,
     cJSON *root = cJSON_CreateObject();
     cJSON_AddItemToObject(root, "data", arr);
     cJSON_AddNumberToObject(root, "count", cJSON_GetArraySize(arr));
+    add_snapshot_age(api, root);
+
+    return send_json(conn, MHD_HTTP_OK, root);
+}
+
+static enum MHD_Result handle_news_search(mc_api_http_t *api,
+                                           struct MHD_Connection *conn)
+{
+    const char *q = MHD_lookup_connection_value(
+        conn, MHD_GET_ARGUMENT_KIND, "q");
+    const char *limit_str = MHD_lookup_connection_value(
+        conn, MHD_GET_ARGUMENT_KIND, "limit");
+
+    if (!q || !*q) {
+        cJSON *err = cJSON_CreateObject();
+        cJSON_AddStringToObject(err, "error", "missing_query");
+        return send_json(conn, MHD_HTTP_BAD_REQUEST, err);
+    }
+
+    int limit = limit_str ? atoi(limit_str) : 50;
+    if (limit <= 0) limit = 50;
+    if (limit > HTTP_MAX_SEARCH) limit = HTTP_MAX_SEARCH;
+
+    mc_news_item_t *news = malloc((size_t)limit * sizeof(mc_news_item_t));
+    if (!news) return MHD_NO;
+    int n = mc_db_search_news(api->db, q, news, limit);
+
+    cJSON *arr = cJSON_CreateArray();
+    for (int i = 0; i < n; i++)
+        cJSON_AddItemToArray(arr, news_to_json(&news[i], 1));
+    free(news);
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "query", q);
+    cJSON_AddItemToObject(root, "data", arr);
+    cJSON_AddNumberToObject(root, "count", n);
 
     return send_json(conn, MHD_HTTP_OK, root);
 }
@@ -143,6 +229,87 @@ static enum MHD_Result handle_status(mc_api_http_t *api,
                             mc_db_count_entries(api->db));
     cJSON_AddNumberToObject(root, "news_count",
                             mc_db_count_news(api->db));
+    cJSON *counts = cJSON_AddObjectToObject(root, "counts");
+    cJSON_AddItemToObject(counts, "entries", row_counts_to_json(api->db, 0));
+    cJSON_AddItemToObject(counts, "news", row_counts_to_json(api->db, 1));
+
+    double first_pass = mc_scheduler_rss_first_pass(api->sched);
+    if (first_pass >= 0)
+        cJSON_AddNumberToObject(root, "rss_first_pass_sec", first_pass);
+    else
+        cJSON_AddNullToObject(root, "rss_first_pass_sec");
+
+    mc_db_writer_stats_t ws;
+    mc_db_get_writer_stats(api->db, &ws);
+    cJSON *writer = cJSON_AddObjectToObject(root, "db_writer");
+    cJSON_AddNumberToObject(writer, "queue_depth", ws.queue_depth);
+    cJSON_AddNumberToObject(writer, "queue_capacity", ws.queue_capacity);
+    cJSON_AddNumberToObject(writer, "enqueued", (double)ws.enqueued);
+    cJSON_AddNumberToObject(writer, "dropped", (double)ws.dropped);
+    cJSON_AddNumberToObject(writer, "skipped_unchanged", (double)ws.skipped);
+    cJSON_AddNumberToObject(writer, "commits", (double)ws.commits);
+    cJSON_AddNumberToObject(writer, "rows_written", (double)ws.rows_written);
+    cJSON_AddNumberToObject(writer, "last_commit_ms", ws.last_commit_ms);
+    cJSON_AddNumberToObject(writer, "avg_commit_ms", ws.avg_commit_ms);
+    cJSON_AddNumberToObject(writer, "max_commit_ms", ws.max_commit_ms);
+
+    mc_db_checkpoint_stats_t cs;
+    mc_db_get_checkpoint_stats(api->db, &cs);
+    cJSON *storage = cJSON_AddObjectToObject(root, "storage");
+    cJSON_AddStringToObject(storage, "mode", cs.in_memory ? "memory" : "disk");
+    if (cs.in_memory) {
+        cJSON_AddNumberToObject(storage, "checkpoint_interval_sec", cs.interval_sec);
+        cJSON_AddNumberToObject(storage, "checkpoints", (double)cs.checkpoints);
+        cJSON_AddNumberToObject(storage, "checkpoint_failures", (double)cs.failures);
+        cJSON_AddNumberToObject(storage, "last_checkpoint", (double)cs.last_at);
+        cJSON_AddNumberToObject(storage, "last_checkpoint_ms", cs.last_ms);
+        cJSON_AddNumberToObject(storage, "last_checkpoint_copy_ms", cs.last_copy_ms);
+        cJSON_AddNumberToObject(storage, "last_checkpoint_bytes", (double)cs.last_bytes);
+    }
+
+    mc_db_maint_stats_t ms;
+    mc_db_get_maint_stats(api->db, &ms);
+    cJSON *maint = cJSON_AddObjectToObject(root, "db_maintenance");
+    for (int i = 0; i < MC_DB_MAINT_COUNT; i++) {
+        const mc_db_maint_task_stats_t *t = &ms.tasks[i];
+        cJSON *task = cJSON_AddObjectToObject(maint, mc_db_maint_task_str(i));
+        cJSON_AddNumberToObject(task, "runs", (double)t->runs);
+        cJSON_AddNumberToObject(task, "failures", (double)t->failures);
+        cJSON_AddNumberToObject(task, "last_run", (double)t->last_at);
+        cJSON_AddNumberToObject(task, "last_ms", t->last_ms);
+        cJSON_AddNumberToObject(task, "avg_ms", t->avg_ms);
+        cJSON_AddNumberToObject(task, "max_ms", t->max_ms);
+    }
+    cJSON_AddNumberToObject(maint, "wal_frames", ms.wal_frames);
+    cJSON_AddNumberToObject(maint, "wal_backfilled", ms.wal_backfilled);
+    cJSON_AddNumberToObject(maint, "freelist_pages", ms.freelist_pages);
+    cJSON_AddNumberToObject(maint, "pages_vacuumed", (double)ms.pages_vacuumed);
+
+    mc_http_host_stats_t *hosts = malloc(MC_HTTP_MAX_HOSTS * sizeof(*hosts));
+    int in_flight = 0;
+    int nh = hosts ? mc_scheduler_get_http_stats(api->sched, &in_flight,
+                                                 hosts, MC_HTTP_MAX_HOSTS) : 0;
+    cJSON *http = cJSON_AddObjectToObject(root, "http");
+    cJSON_AddNumberToObject(http, "in_flight", in_flight);
+    cJSON *harr = cJSON_AddArrayToObject(http, "hosts");
+    for (int i = 0; i < nh; i++) {
+        cJSON *h = cJSON_CreateObject();
+        cJSON_AddStringToObject(h, "host", hosts[i].host);
+        cJSON_AddNumberToObject(h, "requests", (double)hosts[i].requests);
+        cJSON_AddNumberToObject(h, "failures", (double)hosts[i].failures);
+        cJSON_AddNumberToObject(h, "new_connections", (double)hosts[i].new_connections);
+        cJSON_AddNumberToObject(h, "reused", (double)hosts[i].reused);
+        cJSON_AddNumberToObject(h, "avg_connect_ms", hosts[i].avg_connect_ms);
+        cJSON_AddNumberToObject(h, "avg_appconnect_ms", hosts[i].avg_appconnect_ms);
+        cJSON_AddNumberToObject(h, "avg_total_ms", hosts[i].avg_total_ms);
+        cJSON_AddNumberToObject(h, "throttled", (double)hosts[i].throttled);
+        cJSON_AddNumberToObject(h, "queued", hosts[i].queued);
+        cJSON_AddNumberToObject(h, "rate_limited", (double)hosts[i].rate_limited);
+        cJSON_AddNumberToObject(h, "refused", (double)hosts[i].refused);
+        cJSON_AddNumberToObject(h, "paused_sec", hosts[i].paused_sec);
+        cJSON_AddItemToArray(harr, h);
+    }
+    free(hosts);
 
     return send_json(conn, MHD_HTTP_OK, root);
 }
@@ -164,6 +331,13 @@ static enum MHD_Result handle_sources(mc_api_http_t *api,
     mc_source_status_t statuses[64];
     int n = mc_db_get_source_statuses(api->db, statuses, 64);
 
+    mc_db_ingest_stats_t *ingest = malloc(MC_MAX_SOURCES * sizeof(*ingest));
+    int ni = ingest ? mc_db_get_ingest_stats(api->db, ingest, MC_MAX_SOURCES) : 0;
+
+    mc_sched_source_stats_t *timing = malloc(2 * MC_MAX_SOURCES * sizeof(*timing));
+    int nt = timing ? mc_scheduler_get_source_stats(api->sched, timing,
+                                                    2 * MC_MAX_SOURCES) : 0;
+
     cJSON *arr = cJSON_CreateArray();
     for (int i = 0; i < n; i++) {
         cJSON *obj = cJSON_CreateObject();
@@ -187,8 +361,48 @@ static enum MHD_Result handle_sources(mc_api_http_t *api,
                              statuses[i].error_count < 3 ? "degraded" : "failing";
         cJSON_AddStringToObject(obj, "health", health);
 
+        for (int j = 0; j < ni; j++) {
+            if (strcmp(ingest[j].source_name, statuses[i].source_name) != 0)
+                continue;
+            uint64_t skipped = ingest[j].received - ingest[j].stored;
+            cJSON_AddNumberToObject(obj, "ticks_received", (double)ingest[j].received);
+            cJSON_AddNumberToObject(obj, "ticks_stored", (double)ingest[j].stored);
+            cJSON_AddNumberToObject(obj, "skip_ratio", ingest[j].received ?
+                (double)skipped / (double)ingest[j].received : 0.0);
+            break;
+        }
+
+        for (int j = 0; j < nt; j++) {
+            if (timing[j].source_type != statuses[i].source_type ||
+                strcmp(timing[j].source_name, statuses[i].source_name) != 0)
+                continue;
+            cJSON *delay = cJSON_AddObjectToObject(obj, "start_delay_ms");
+            cJSON_AddNumberToObject(delay, "last", (double)timing[j].delay_last_ms);
+            cJSON_AddNumberToObject(delay, "avg", timing[j].delay_avg_ms);
+            cJSON_AddNumberToObject(delay, "max", (double)timing[j].delay_max_ms);
+            cJSON_AddNumberToObject(obj, "fetches", (double)timing[j].fetches);
+            cJSON_AddNumberToObject(obj, "not_modified", (double)timing[j].not_modified);
+            cJSON_AddNumberToObject(obj, "not_modified_ratio",
+                (double)timing[j].not_modified / (double)timing[j].fetches);
+            cJSON_AddNumberToObject(obj, "bytes_saved", (double)timing[j].bytes_saved);
+            cJSON_AddNumberToObject(obj, "bytes_wire", (double)timing[j].bytes_wire);
+            cJSON_AddNumberToObject(obj, "bytes_decoded", (double)timing[j].bytes_decoded);
+            cJSON_AddNumberToObject(obj, "compression_ratio", timing[j].bytes_wire ?
+                (double)timing[j].bytes_decoded / (double)timing[j].bytes_wire : 1.0);
+            cJSON_AddNumberToObject(obj, "interval_sec", timing[j].interval_sec);
+            cJSON_AddNumberToObject(obj, "changes", (double)timing[j].changes);
+            cJSON_AddStringToObject(obj, "rate_limit",
+                                    timing[j].retry_in_sec > 0 ? "limited" : "ok");
+            cJSON_AddNumberToObject(obj, "rate_limited", (double)timing[j].rate_limited);
+            if (timing[j].retry_in_sec > 0)
+                cJSON_AddNumberToObject(obj, "retry_in_sec", timing[j].retry_in_sec);
+            break;
+        }
+
         cJSON_AddItemToArray(arr, obj);
     }
+    free(ingest);
+    free(timing);
 
     cJSON *root = cJSON_CreateObject();
     cJSON_AddItemToObject(root, "sources", arr);
@@ -216,6 +430,64 @@ static enum MHD_Result handle_history(mc_api_http_t *api,
     return send_json(conn, MHD_HTTP_OK, root);
 }
 
+static enum MHD_Result handle_candles(mc_api_http_t *api,
+                                       struct MHD_Connection *conn,
+                                       const char *symbol)
+{
+    const char *res_str = MHD_lookup_connection_value(
+        conn, MHD_GET_ARGUMENT_KIND, "res");
+    const char *from_str = MHD_lookup_connection_value(
+        conn, MHD_GET_ARGUMENT_KIND, "from");
+    const char *to_str = MHD_lookup_connection_value(
+        conn, MHD_GET_ARGUMENT_KIND, "to");
+    const char *source = MHD_lookup_connection_value(
+        conn, MHD_GET_ARGUMENT_KIND, "source");
+
+    if (!res_str) res_str = "1m";
+    int res = mc_db_candle_res_parse(res_str);
+    if (res == 0) {
+        cJSON *err = cJSON_CreateObject();
+        cJSON_AddStringToObject(err, "error", "bad_resolution");
+        cJSON_AddStringToObject(err, "res", res_str);
+        return send_json(conn, MHD_HTTP_BAD_REQUEST, err);
+    }
+
+    /* Default window: the last HTTP_MAX_CANDLES intervals */
+    time_t to = to_str ? (time_t)strtoll(to_str, NULL, 10) : time(NULL);
+    time_t from = from_str ? (time_t)strtoll(from_str, NULL, 10)
+                           : to - (time_t)res * HTTP_MAX_CANDLES;
+
+    mc_candle_t *candles = malloc(HTTP_MAX_CANDLES * sizeof(mc_candle_t));
+    if (!candles) return MHD_NO;
+    int n = mc_db_get_candles(api->db, symbol, res, source, from, to,
+                              candles, HTTP_MAX_CANDLES);
+
+    cJSON *arr = cJSON_CreateArray();
+    for (int i = 0; i < n; i++) {
+        cJSON *obj = cJSON_CreateObject();
+        cJSON_AddStringToObject(obj, "source", candles[i].source_name);
+        cJSON_AddNumberToObject(obj, "t", (double)candles[i].bucket);
+        cJSON_AddNumberToObject(obj, "open", candles[i].open);
+        cJSON_AddNumberToObject(obj, "high", candles[i].high);
+        cJSON_AddNumberToObject(obj, "low", candles[i].low);
+        cJSON_AddNumberToObject(obj, "close", candles[i].close);
+        cJSON_AddNumberToObject(obj, "volume", candles[i].volume);
+        cJSON_AddNumberToObject(obj, "ticks", candles[i].ticks);
+        cJSON_AddItemToArray(arr, obj);
+    }
+    free(candles);
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "symbol", symbol);
+    cJSON_AddStringToObject(root, "res", res_str);
+    cJSON_AddNumberToObject(root, "from", (double)from);
+    cJSON_AddNumberToObject(root, "to", (double)to);
+    cJSON_AddItemToObject(root, "data", arr);
+    cJSON_AddNumberToObject(root, "count", n);
+
+    return send_json(conn, MHD_HTTP_OK, root);
+}
+
 static enum MHD_Result request_handler(void *cls,
                                         struct MHD_Connection *conn,
                                         const char *url,
@@ -249,6 +521,9 @@ static enum MHD_Result request_handler(void *cls,
     if (strcmp(url, "/api/v1/news") == 0 && strcmp(method, "GET") == 0)
         return handle_news(api, conn);
 
+    if (strcmp(url, "/api/v1/news/search") == 0 && strcmp(method, "GET") == 0)
+        return handle_news_search(api, conn);
+
     if (strcmp(url, "/api/v1/status") == 0 && strcmp(method, "GET") == 0)
         return handle_status(api, conn);
 
@@ -258,19 +533,22 @@ static enum MHD_Result request_handler(void *cls,
     if (strcmp(url, "/api/v1/refresh") == 0 && strcmp(method, "POST") == 0)
         return handle_refresh(api, conn);
 
-    /* /api/v1/entries/<symbol>/history */
-    const char *hist_prefix = "/api/v1/entries/";
-    const char *hist_suffix = "/history";
-    if (strncmp(url, hist_prefix, strlen(hist_prefix)) == 0 &&
+    /* /api/v1/entries/<symbol>/history and /api/v1/entries/<symbol>/candles */
+    const char *sym_prefix = "/api/v1/entries/";
+    if (strncmp(url, sym_prefix, strlen(sym_prefix)) == 0 &&
         strcmp(method, "GET") == 0) {
-        const char *sym_start = url + strlen(hist_prefix);
-        const char *sym_end = strstr(sym_start, hist_suffix);
+        const char *sym_start = url + strlen(sym_prefix);
+        const char *hist_end = strstr(sym_start, "/history");
+        const char *candles_end = strstr(sym_start, "/candles");
+        const char *sym_end = hist_end ? hist_end : candles_end;
         if (sym_end) {
             char symbol[MC_MAX_SYMBOL] = {0};
             size_t len = (size_t)(sym_end - sym_start);
             if (len >= MC_MAX_SYMBOL) len = MC_MAX_SYMBOL - 1;
             strncpy(symbol, sym_start, len);
-            return handle_history(api, conn, symbol);
+            if (sym_end == hist_end)
+                return handle_history(api, conn, symbol);
+            return handle_candles(api, conn, symbol);
         }
     }
 
@@ -295,6 +573,7 @@ mc_api_http_t *mc_api_http_start(int port, mc_scheduler_t *sched, mc_db_t *db)
         (uint16_t)port,
         NULL, NULL,
         request_handler, api,
+        MHD_OPTION_THREAD_POOL_SIZE, (unsigned int)HTTP_THREAD_POOL_SIZE,
         MHD_OPTION_END);
 
     if (!api->daemon) {
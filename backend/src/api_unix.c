@@ -13,6 +13,7 @@
 #include <time.h>
 
 #define UNIX_BUF_SIZE 65536
+#define UNIX_MAX_ROW_COUNTS 4096  /* (source, category) groups in status */
 
 struct mc_api_unix {
     char            socket_path[512];
@@ -52,6 +53,41 @@ static cJSON *news_to_json(const mc_news_item_t *n)
     return obj;
 }
 
+/* Entry or news row counts keyed by category and by source */
+static cJSON *row_counts_to_json(mc_db_t *db, int news)
+{
+    cJSON *obj = cJSON_CreateObject();
+    cJSON *by_cat = cJSON_AddObjectToObject(obj, "by_category");
+    cJSON *by_src = cJSON_AddObjectToObject(obj, "by_source");
+    mc_db_row_count_t *counts = malloc(UNIX_MAX_ROW_COUNTS * sizeof(*counts));
+    if (!counts) return obj;
+
+    int n = mc_db_get_row_counts(db, news, counts, UNIX_MAX_ROW_COUNTS);
+    for (int i = 0; i < n; i++) {
+        cJSON *groups[2] = { by_cat, by_src };
+        const char *keys[2] = { mc_category_str(counts[i].category),
+                                counts[i].source_name };
+        for (int k = 0; k < 2; k++) {
+            cJSON *item = cJSON_GetObjectItemCaseSensitive(groups[k], keys[k]);
+            if (item)
+                cJSON_SetNumberValue(item, item->valuedouble + (double)counts[i].rows);
+            else
+                cJSON_AddNumberToObject(groups[k], keys[k], (double)counts[i].rows);
+        }
+    }
+    free(counts);
+    return obj;
+}
+
+/* "stale" is set while the snapshot is the previous run's warm copy */
+static void add_snapshot_age(mc_api_unix_t *api, cJSON *root)
+{
+    int warm = 0;
+    time_t built_at = mc_scheduler_snapshot_time(api->sched, &warm);
+    cJSON_AddNumberToObject(root, "as_of", (double)built_at);
+    cJSON_AddBoolToObject(root, "stale", warm);
+}
+
 static cJSON *handle_request(mc_api_unix_t *api, cJSON *req)
 {
     const char *path = cJSON_GetStringValue(cJSON_GetObjectItem(req, "path"));
@@ -62,24 +98,28 @@ static cJSON *handle_request(mc_api_unix_t *api, cJSON *req)
     }
 
     if (strcmp(path, "/api/v1/entries") == 0) {
-        mc_data_entry_t *entries = malloc(2048 * sizeof(mc_data_entry_t));
+        mc_entry_rec_t *entries = malloc(2048 * sizeof(mc_entry_rec_t));
         if (!entries) return NULL;
         int n = mc_scheduler_get_entries(api->sched, entries, 2048);
 
         cJSON *arr = cJSON_CreateArray();
-        for (int i = 0; i < n; i++)
-            cJSON_AddItemToArray(arr, entry_to_json(&entries[i]));
+        for (int i = 0; i < n; i++) {
+            mc_data_entry_t e;
+            mc_entry_unpack(&entries[i], &e);
+            cJSON_AddItemToArray(arr, entry_to_json(&e));
+        }
 
         free(entries);
         cJSON *root = cJSON_CreateObject();
         cJSON_AddItemToObject(root, "data", arr);
         cJSON_AddNumberToObject(root, "count", n);
+        add_snapshot_age(api, root);
         return root;
     }
 
     if (strcmp(path, "/api/v1/news") == 0) {
         mc_news_item_t news[256];
-        int n = mc_scheduler_get_news(api->sched, news, 256);
+        int n = mc_scheduler_get_news(api->sched, news, 256, 0);
 
         cJSON *arr = cJSON_CreateArray();
         for (int i = 0; i < n; i++)
@@ -88,6 +128,7 @@ static cJSON *handle_request(mc_api_unix_t *api, cJSON *req)
         cJSON *root = cJSON_CreateObject();
         cJSON_AddItemToObject(root, "data", arr);
         cJSON_AddNumberToObject(root, "count", n);
+        add_snapshot_age(api, root);
         return root;
     }
 
@@ -100,6 +141,9 @@ static cJSON *handle_request(mc_api_unix_t *api, cJSON *req)
                                 mc_db_count_entries(api->db));
         cJSON_AddNumberToObject(root, "news_count",
                                 mc_db_count_news(api->db));
+        cJSON *counts = cJSON_AddObjectToObject(root, "counts");
+        cJSON_AddItemToObject(counts, "entries", row_counts_to_json(api->db, 0));
+        cJSON_AddItemToObject(counts, "news", row_counts_to_json(api->db, 1));
         return root;
     }
 
@@ -20,6 +20,12 @@ void mc_config_defaults(mc_config_t *cfg)
     safe_copy(cfg->db_path, "~/.monitorcrebirth/monitorcrebirth.db", MC_MAX_PATH);
     safe_copy(cfg->log_level, "info", 16);
     cfg->max_items_per_source = 50;
+    cfg->tick_heartbeat_sec = 300;
+    safe_copy(cfg->storage, "disk", sizeof(cfg->storage));
+    cfg->checkpoint_interval_sec = 60;
+    cfg->rss_workers = 32;
+    cfg->host_rate_per_sec = 5.0;
+    cfg->host_burst = 10.0;
     cfg->http_port = 8420;
     safe_copy(cfg->unix_socket_path, "~/.monitorcrebirth/mc.sock", MC_MAX_PATH);
     cfg->default_tab = 0;
@@ -45,6 +51,28 @@ static void expand_tilde(char *path, size_t n)
     path[n - 1] = '\0';
 }
 
+/* refresh_min_sec / refresh_max_sec let the scheduler adapt a source's
+   interval to how often its content changes. A missing bound defaults to
+   refresh_interval_sec, which is then the starting interval. */
+static void parse_refresh_bounds(toml_table_t *t, const char *name,
+                                 int *interval, int *min_sec, int *max_sec)
+{
+    if (*interval < 1) *interval = 1;
+    toml_datum_t d = toml_int_in(t, "refresh_min_sec");
+    *min_sec = d.ok ? (int)d.u.i : *interval;
+    d = toml_int_in(t, "refresh_max_sec");
+    *max_sec = d.ok ? (int)d.u.i : *interval;
+
+    if (*min_sec < 1) *min_sec = 1;
+    if (*max_sec < *min_sec) {
+        MC_LOG_WARN("Source %s: refresh_max_sec below refresh_min_sec, using %d",
+                    name, *min_sec);
+        *max_sec = *min_sec;
+    }
+    if (*interval < *min_sec) *interval = *min_sec;
+    if (*interval > *max_sec) *interval = *max_sec;
+}
+
 static void parse_rss_sources(toml_table_t *source_tbl, mc_config_t *cfg)
 {
     toml_array_t *arr = toml_array_in(source_tbl, "rss");
@@ -70,6 +98,8 @@ static void parse_rss_sources(toml_table_t *source_tbl, mc_config_t *cfg)
 
         d = toml_int_in(t, "refresh_interval_sec");
         s->refresh_interval_sec = d.ok ? (int)d.u.i : cfg->refresh_interval_sec;
+        parse_refresh_bounds(t, s->name, &s->refresh_interval_sec,
+                             &s->refresh_min_sec, &s->refresh_max_sec);
 
         d = toml_int_in(t, "tier");
         s->tier = d.ok ? (int)d.u.i : 3;
@@ -82,6 +112,9 @@ static void parse_rss_sources(toml_table_t *source_tbl, mc_config_t *cfg)
         d = toml_string_in(t, "country");
         if (d.ok) { safe_copy(s->country, d.u.s, MC_MAX_COUNTRY); free(d.u.s); }
 
+        d = toml_bool_in(t, "compression");
+        s->compression = d.ok ? d.u.b : 1;
+
         cfg->rss_count++;
     }
 }
@@ -131,6 +164,8 @@ static void parse_rest_sources(toml_table_t *source_tbl, mc_config_t *cfg)
 
         d = toml_int_in(t, "refresh_interval_sec");
         s->refresh_interval_sec = d.ok ? (int)d.u.i : cfg->refresh_interval_sec;
+        parse_refresh_bounds(t, s->name, &s->refresh_interval_sec,
+                             &s->refresh_min_sec, &s->refresh_max_sec);
 
         /* Parse symbols array */
         toml_array_t *syms = toml_array_in(t, "symbols");
@@ -166,10 +201,47 @@ static void parse_rest_sources(toml_table_t *source_tbl, mc_config_t *cfg)
         d = toml_string_in(t, "currency");
         if (d.ok) { safe_copy(s->currency, d.u.s, MC_MAX_SYMBOL); free(d.u.s); }
 
+        d = toml_bool_in(t, "compression");
+        s->compression = d.ok ? d.u.b : 1;
+
         cfg->rest_count++;
     }
 }
 
+/* TOML keeps integers and floats apart; accept either */
+static int number_in(toml_table_t *t, const char *key, double *out)
+{
+    toml_datum_t d = toml_double_in(t, key);
+    if (d.ok) { *out = d.u.d; return 1; }
+    d = toml_int_in(t, key);
+    if (d.ok) { *out = (double)d.u.i; return 1; }
+    return 0;
+}
+
+static void parse_rate_limits(toml_table_t *root, mc_config_t *cfg)
+{
+    toml_array_t *arr = toml_array_in(root, "rate_limit");
+    if (!arr) return;
+
+    int n = toml_array_nelem(arr);
+    for (int i = 0; i < n && cfg->rate_limit_count < MC_MAX_RATE_LIMITS; i++) {
+        toml_table_t *t = toml_table_at(arr, i);
+        if (!t) continue;
+
+        mc_rate_limit_cfg_t *r = &cfg->rate_limits[cfg->rate_limit_count];
+        memset(r, 0, sizeof(*r));
+
+        toml_datum_t d = toml_string_in(t, "host");
+        if (!d.ok) continue;
+        safe_copy(r->host, d.u.s, MC_MAX_HOST);
+        free(d.u.s);
+
+        if (!number_in(t, "per_sec", &r->per_sec)) r->per_sec = cfg->host_rate_per_sec;
+        if (!number_in(t, "burst", &r->burst)) r->burst = cfg->host_burst;
+        cfg->rate_limit_count++;
+    }
+}
+
 static void parse_ws_sources(toml_table_t *source_tbl, mc_config_t *cfg)
 {
     toml_array_t *arr = toml_array_in(source_tbl, "websocket");
@@ -237,6 +309,21 @@ int mc_config_load(const char *path, mc_config_t *cfg)
 
         d = toml_int_in(gen, "max_items_per_source");
         if (d.ok) cfg->max_items_per_source = (int)d.u.i;
+
+        d = toml_int_in(gen, "tick_heartbeat_sec");
+        if (d.ok) cfg->tick_heartbeat_sec = d.u.i > 0 ? (int)d.u.i : 0;
+
+        d = toml_string_in(gen, "storage");
+        if (d.ok) { safe_copy(cfg->storage, d.u.s, sizeof(cfg->storage)); free(d.u.s); }
+
+        d = toml_int_in(gen, "checkpoint_interval_sec");
+        if (d.ok && d.u.i > 0) cfg->checkpoint_interval_sec = (int)d.u.i;
+
+        d = toml_int_in(gen, "rss_workers");
+        if (d.ok && d.u.i > 0) cfg->rss_workers = (int)d.u.i;
+
+        number_in(gen, "host_rate_per_sec", &cfg->host_rate_per_sec);
+        number_in(gen, "host_burst", &cfg->host_burst);
     }
 
     /* [api] */
@@ -283,6 +370,9 @@ int mc_config_load(const char *path, mc_config_t *cfg)
         parse_ws_sources(source, cfg);
     }
 
+    /* [[rate_limit]], after [general] so its defaults apply */
+    parse_rate_limits(root, cfg);
+
     /* Expand tilde in paths */
     expand_tilde(cfg->db_path, MC_MAX_PATH);
     expand_tilde(cfg->unix_socket_path, MC_MAX_PATH);
@@ -1,48 +1,511 @@
 #include "mc_db.h"
+#include "mc_intern.h"
 #include "mc_log.h"
+#include "mc_summary.h"
+#include "mc_ticks.h"
 
 #include <sqlite3.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
+
+/* Statements compiled once in mc_db_migrate() and reused (reset + rebind)
+   for the lifetime of the connection. */
+typedef enum {
+    STMT_BEGIN,
+    STMT_COMMIT,
+    STMT_ROLLBACK,
+    STMT_UPSERT_LATEST_ENTRY,
+    STMT_UPSERT_CANDLE,
+    STMT_INSERT_NEWS,
+    STMT_LATEST_ENTRIES_BY_VOLUME,
+    STMT_LATEST_ENTRIES_BY_NAME,
+    STMT_LATEST_NEWS,
+    STMT_ALL_LATEST_NEWS,
+    STMT_SEARCH_NEWS,
+    STMT_ENTRY_HISTORY,
+    STMT_CANDLES,
+    STMT_UPDATE_SOURCE_STATUS,
+    STMT_TOUCH_LATEST_ENTRIES,
+    STMT_TOUCH_NEWS,
+    STMT_INSERT_STRING,
+    STMT_PRUNE_LATEST_ENTRIES,
+    STMT_PRUNE_NEWS,
+    STMT_PRUNE_CANDLES,
+    STMT_SOURCE_STATUSES,
+    STMT_COUNT
+} stmt_id_t;
+
+/* Latest entry per (category, symbol, source_name), kept current by
+   STMT_UPSERT_LATEST_ENTRY so reads cost O(symbols), not O(history). */
+#define LATEST_ENTRIES_SQL(order)                                  \
+    "SELECT entry_id,source_name,source_type,category,symbol,"     \
+    "display_name,value,currency,change_pct,volume,"               \
+    "timestamp,fetched_at FROM latest_entries "                    \
+    "WHERE category=? " order " LIMIT ?"
+
+static const char *STMT_SQL[STMT_COUNT] = {
+    [STMT_BEGIN]    = "BEGIN IMMEDIATE",
+    [STMT_COMMIT]   = "COMMIT",
+    [STMT_ROLLBACK] = "ROLLBACK",
+
+    /* Same bindings as ENTRY_INSERT_SQL; run right after it so
+       last_insert_rowid() is the history row just written. */
+    [STMT_UPSERT_LATEST_ENTRY] =
+        "INSERT INTO latest_entries "
+        "(source_name,source_type,category,symbol,display_name,"
+        "value,currency,change_pct,volume,timestamp,fetched_at,entry_id) "
+        "VALUES (?,?,?,?,?,?,?,?,?,?,?,last_insert_rowid()) "
+        "ON CONFLICT(category,symbol,source_name) DO UPDATE SET "
+        "source_type=excluded.source_type,display_name=excluded.display_name,"
+        "value=excluded.value,currency=excluded.currency,"
+        "change_pct=excluded.change_pct,volume=excluded.volume,"
+        "timestamp=excluded.timestamp,fetched_at=excluded.fetched_at,"
+        "entry_id=excluded.entry_id "
+        "WHERE excluded.fetched_at >= latest_entries.fetched_at",
+
+    /* ?1 symbol, ?2 source, ?3 resolution, ?4 bucket, ?5 value, ?6 volume */
+    [STMT_UPSERT_CANDLE] =
+        "INSERT INTO candles "
+        "(symbol,source_name,res,bucket,open,high,low,close,volume,ticks) "
+        "VALUES (?1,?2,?3,?4,?5,?5,?5,?5,?6,1) "
+        "ON CONFLICT(symbol,res,bucket,source_name) DO UPDATE SET "
+        "high=max(high,excluded.high),low=min(low,excluded.low),"
+        "close=excluded.close,volume=excluded.volume,ticks=ticks+1",
+
+    [STMT_INSERT_NEWS] =
+        "INSERT INTO news_items "
+        "(title,source,url,summary_z,category,published_at,fetched_at,base_score,region,country) "
+        "VALUES (?,?,?,?,?,?,?,?,?,?) "
+        "ON CONFLICT(url) DO UPDATE SET region=excluded.region, country=excluded.country "
+        "WHERE excluded.region != '' AND (region IS NULL OR region = '')",
 
-struct mc_db {
+    [STMT_LATEST_ENTRIES_BY_VOLUME] =
+        LATEST_ENTRIES_SQL("ORDER BY volume DESC, symbol"),
+
+    [STMT_LATEST_ENTRIES_BY_NAME] =
+        LATEST_ENTRIES_SQL("ORDER BY source_name, symbol"),
+
+    [STMT_LATEST_NEWS] =
+        "SELECT id,title,source,url,summary_z,category,published_at,fetched_at,base_score,region,country "
+        "FROM news_items WHERE category=? "
+        "ORDER BY base_score DESC, published_at DESC LIMIT ?",
+
+    [STMT_ALL_LATEST_NEWS] =
+        "SELECT id,title,source,url,summary_z,category,published_at,fetched_at,base_score,region,country "
+        "FROM news_items "
+        "ORDER BY base_score DESC, published_at DESC LIMIT ?",
+
+    /* bm25() is negative, better matches lower; scaling it by base_score
+       (0-100, default 50) lifts high-impact items among similar matches.
+       Title hits weigh 10x summary hits, source names 2x. */
+    [STMT_SEARCH_NEWS] =
+        "SELECT n.id,n.title,n.source,n.url,n.summary_z,n.category,n.published_at,"
+        "n.fetched_at,n.base_score,n.region,n.country "
+        "FROM news_fts JOIN news_items n ON n.id=news_fts.rowid "
+        "WHERE news_fts MATCH ? "
+        "ORDER BY bm25(news_fts,10.0,1.0,2.0) * (0.5 + coalesce(n.base_score,50.0) / 100.0), "
+        "n.published_at DESC LIMIT ?",
+
+    [STMT_ENTRY_HISTORY] =
+        "SELECT id,source_name,source_type,category,symbol,display_name,"
+        "value,currency,change_pct,volume,timestamp,fetched_at "
+        "FROM data_entries WHERE symbol=? "
+        "ORDER BY timestamp DESC LIMIT ?",
+
+    /* Newest first so LIMIT keeps the end of the range; ?5 NULL = any source */
+    [STMT_CANDLES] =
+        "SELECT source_name,bucket,open,high,low,close,volume,ticks "
+        "FROM candles WHERE symbol=?1 AND res=?2 AND bucket BETWEEN ?3 AND ?4 "
+        "AND (?5 IS NULL OR source_name=?5) "
+        "ORDER BY bucket DESC, source_name LIMIT ?6",
+
+    [STMT_UPDATE_SOURCE_STATUS] =
+        "INSERT INTO source_status (source_name,source_type,last_fetched,last_error,error_count) "
+        "VALUES (?,?,?,?,?) "
+        "ON CONFLICT(source_name) DO UPDATE SET "
+        "last_fetched=excluded.last_fetched,"
+        "last_error=excluded.last_error,"
+        "error_count=CASE WHEN excluded.last_error IS NULL THEN 0 "
+        "ELSE source_status.error_count+1 END",
+
+    /* ?1 fetched_at, ?2 source: the source answered "not modified", so
+       its stored rows are current and must outlive the age prune */
+    [STMT_TOUCH_LATEST_ENTRIES] =
+        "UPDATE latest_entries SET fetched_at=?1 "
+        "WHERE source_name=?2 AND fetched_at < ?1",
+
+    [STMT_TOUCH_NEWS] =
+        "UPDATE news_items SET fetched_at=?1 WHERE source=?2 AND fetched_at < ?1",
+
+    /* Dictionary ids come from mc_intern(); a row is never rewritten */
+    [STMT_INSERT_STRING] =
+        "INSERT OR IGNORE INTO strings (id,value) VALUES (?,?)",
+
+    [STMT_PRUNE_LATEST_ENTRIES] =
+        "DELETE FROM latest_entries WHERE fetched_at < ?",
+
+    /* Returns what it deleted so the row counters can follow */
+    [STMT_PRUNE_NEWS] =
+        "DELETE FROM news_items WHERE fetched_at < ? RETURNING source,category",
+
+    [STMT_PRUNE_CANDLES] =
+        "DELETE FROM candles WHERE res=? AND bucket < ?",
+
+    [STMT_SOURCE_STATUSES] =
+        "SELECT source_name,source_type,last_fetched,last_error,error_count "
+        "FROM source_status ORDER BY source_name",
+};
+
+/* Candle resolutions rolled up at ingest; keep_sec 0 = never pruned */
+static const struct {
+    const char *name;
+    int         sec;
+    int         keep_sec;
+} CANDLE_RES[] = {
+    { "1m", 60,    2 * 86400 },
+    { "5m", 300,   14 * 86400 },
+    { "1h", 3600,  180 * 86400 },
+    { "1d", 86400, 0 },
+};
+
+#define CANDLE_RES_COUNT (int)(sizeof(CANDLE_RES) / sizeof(CANDLE_RES[0]))
+
+/* data_entries is a view over data_entries_<start> tables, one per
+   ENTRY_PARTITION_SEC span of fetched_at, so retention drops whole
+   tables instead of running DELETE scans. Partitions store the four
+   strings as ids into the strings dictionary; the view joins them back. */
+#define ENTRY_PARTITION_SEC  600
+#define ENTRY_PARTITION_MAX  480   /* The view is one compound SELECT,
+                                      which SQLite caps at 500 terms */
+
+#define ENTRY_PARTITION_DDL                                        \
+    "CREATE TABLE %s ("                                            \
+    "  id           INTEGER PRIMARY KEY AUTOINCREMENT,"            \
+    "  source_id    INTEGER NOT NULL,"                             \
+    "  source_type  INTEGER NOT NULL,"                             \
+    "  category     INTEGER NOT NULL,"                             \
+    "  symbol_id    INTEGER NOT NULL,"                             \
+    "  display_id   INTEGER NOT NULL,"                             \
+    "  value        REAL,"                                         \
+    "  currency_id  INTEGER NOT NULL,"                             \
+    "  change_pct   REAL,"                                         \
+    "  volume       REAL,"                                         \
+    "  timestamp    INTEGER NOT NULL,"                             \
+    "  fetched_at   INTEGER NOT NULL"                              \
+    ");"                                                           \
+    "CREATE INDEX idx_%s_symbol ON %s(symbol_id);"                 \
+    "INSERT INTO sqlite_sequence (name,seq) VALUES ('%s',0);"
+
+/* Ids stay unique across partitions: whenever the writer switches tables,
+   the target's AUTOINCREMENT counter is lifted to the highest in use */
+#define ENTRY_SEQ_LIFT_SQL                                         \
+    "UPDATE sqlite_sequence SET seq=(SELECT max(seq) FROM sqlite_sequence " \
+    "WHERE name GLOB 'data_entries_[0-9]*') WHERE name='%s'"
+
+#define ENTRY_INSERT_SQL                                           \
+    "INSERT INTO %s "                                              \
+    "(source_id,source_type,category,symbol_id,display_id,"        \
+    "value,currency_id,change_pct,volume,timestamp,fetched_at) "   \
+    "VALUES (?,?,?,?,?,?,?,?,?,?,?)"
+
+/* One arm of the data_entries view */
+#define ENTRY_VIEW_SELECT                                          \
+    "SELECT p.id,src.value AS source_name,p.source_type,p.category," \
+    "sym.value AS symbol,dn.value AS display_name,p.value,"        \
+    "cur.value AS currency,p.change_pct,p.volume,p.timestamp,"     \
+    "p.fetched_at FROM %s p "                                      \
+    "JOIN strings src ON src.id=p.source_id "                      \
+    "JOIN strings sym ON sym.id=p.symbol_id "                      \
+    "JOIN strings dn ON dn.id=p.display_id "                       \
+    "JOIN strings cur ON cur.id=p.currency_id"
+
+#define WRITER_QUEUE_CAP   1024  /* Pending write jobs (power of two) */
+#define WRITER_GROUP_JOBS  64    /* Max jobs folded into one transaction */
+#define WRITER_GROUP_ROWS  8192  /* ...or max rows, whichever comes first */
+
+/* One producer request: a fetch result or a source status update,
+   copied so the producer's buffers can be reused immediately. */
+typedef enum {
+    JOB_ENTRIES,
+    JOB_NEWS,
+    JOB_SOURCE_STATUS,
+    JOB_TOUCH_ENTRIES,
+    JOB_TOUCH_NEWS
+} db_job_kind_t;
+
+typedef struct {
+    char             source_name[MC_MAX_SOURCE];
+    mc_source_type_t type;
+    time_t           at;
+    int              has_error;
+    char             error[256];
+} status_row_t;
+
+typedef struct {
+    char             source_name[MC_MAX_SOURCE];
+    time_t           at;
+} touch_row_t;
+
+typedef struct {
+    db_job_kind_t kind;
+    int           count;
+    unsigned char *written; /* count flags set by apply_job, after the rows */
+    unsigned char rows[];   /* count * row size for kind */
+} db_job_t;
+
+/* Bounded lock-free multi-producer / single-consumer ring (Vyukov):
+   each cell's sequence number tells producers whether it is free and
+   the writer whether it has been published. */
+typedef struct {
+    _Atomic size_t seq;
+    db_job_t      *job;
+} job_cell_t;
+
+typedef struct {
+    job_cell_t     cells[WRITER_QUEUE_CAP];
+    _Atomic size_t head;  /* next slot a producer claims */
+    _Atomic size_t tail;  /* next slot the writer drains */
+} job_queue_t;
+
+#define DB_READ_POOL_SIZE  6     /* HTTP pool threads + Unix API + snapshot */
+
+/* Maintenance: commits only checkpoint the WAL themselves past this many
+   pages (SQLite's default is 1000), as a backstop if the maintenance
+   thread stalls; each incremental vacuum returns at most MAINT_VACUUM_PAGES
+   so its write lock stays short; TRUNCATE gives up after MAINT_BUSY_MS */
+#define WAL_AUTOCHECKPOINT_PAGES 4096
+#define MAINT_VACUUM_PAGES       2048
+#define MAINT_BUSY_MS            1000
+
+#define INGEST_SOURCES_MAX 512   /* REST + WebSocket sources */
+
+/* Last quote stored for one (source, symbol); key is source_id << 32 |
+   symbol_id, UINT64_MAX marks a free slot */
+typedef struct {
+    uint64_t key;
+    double   value;
+    double   change_pct;
+    double   volume;
+    time_t   stored_at;
+} last_quote_t;
+
+typedef struct {
+    uint32_t source_id;
+    uint64_t received;
+    uint64_t stored;
+} ingest_count_t;
+
+/* Row counts per (source, category), so status never runs COUNT(*).
+   Open addressing on source_id << 8 | category, UINT64_MAX marks a free
+   slot; a slot stays once used even if its count drops to zero. */
+typedef struct {
+    uint64_t key;
+    int64_t  rows;
+} tally_slot_t;
+
+typedef struct {
+    tally_slot_t *slots;
+    uint32_t      cap;    /* Power of two */
+    uint32_t      used;
+    int64_t       total;
+} tally_t;
+
+/* One SQLite connection with its own lock and statement cache */
+typedef struct {
     sqlite3        *handle;
     pthread_mutex_t mutex;
+    sqlite3_stmt   *stmts[STMT_COUNT];
+} db_conn_t;
+
+struct mc_db {
+    char           *path;
+    char           *uri;          /* What connections open: path, or a memdb URI */
+
+    /* In-memory mode: every connection shares one memdb database and
+       the checkpoint thread writes a serialized image of it to path */
+    int             in_memory;
+    int             checkpoint_sec;
+    pthread_t       checkpoint_thread;
+    int             checkpoint_active;
+    int             checkpoint_quit;
+    pthread_mutex_t checkpoint_mutex;   /* Guards the stop flag and stats */
+    pthread_cond_t  checkpoint_cond;
+    sqlite3        *checkpoint_src;     /* Read-only memdb connection */
+    uint64_t        checkpoints;
+    uint64_t        checkpoint_failures;
+    time_t          last_checkpoint_at;
+    double          last_checkpoint_ms;
+    double          last_checkpoint_copy_ms;
+    uint64_t        last_checkpoint_bytes;
+
+    /* Read-write connection, used by the writer thread and pruning */
+    db_conn_t       rw;
+
+    /* Maintenance connection (mc_db_maintain) and its stats, the latter
+       guarded by maint_mutex */
+    sqlite3        *maint;
+    pthread_mutex_t maint_mutex;
+    mc_db_maint_task_stats_t maint_tasks[MC_DB_MAINT_COUNT];
+    double          maint_total_ms[MC_DB_MAINT_COUNT];
+    int             wal_frames;
+    int             wal_backfilled;
+    int             freelist_pages;
+    uint64_t        pages_vacuumed;
+
+    /* Read-only connections for API/snapshot queries; WAL lets them run
+       alongside the writer instead of queueing behind rw.mutex (memdb has
+       no WAL, so there a commit waits for running reads) */
+    db_conn_t       readers[DB_READ_POOL_SIZE];
+    int             reader_count;
+    atomic_uint     reader_next;
+
+    /* Dedicated writer thread fed by producers through the ring */
+    job_queue_t     queue;
+    sem_t           writer_wake;
+    pthread_t       writer_thread;
+    int             writer_active;
+    atomic_int      writer_running;
+
+    /* Writer counters and commit hook, guarded by writer_mutex */
+    pthread_mutex_t writer_mutex;
+    _Atomic uint64_t enqueued;
+    _Atomic uint64_t dropped;
+    uint64_t        commits;
+    uint64_t        rows_written;
+    double          last_commit_ms;
+    double          total_commit_ms;
+    double          max_commit_ms;
+    mc_db_commit_hook_fn commit_hook;
+    void           *commit_hook_ctx;
+
+    /* Change-only ingest cache (open addressing, at most half full) and
+       per-source counters, guarded by ingest_mutex */
+    pthread_mutex_t ingest_mutex;
+    int             tick_heartbeat_sec;
+    last_quote_t   *quotes;
+    uint32_t        quote_cap;
+    uint32_t        quote_count;
+    ingest_count_t  ingest[INGEST_SOURCES_MAX];
+
+    /* Row counts of data_entries and news_items, guarded by counts_mutex.
+       Inserts and prunes collect deltas in pending_* (under rw.mutex) that
+       are folded in only once their transaction commits. */
+    pthread_mutex_t counts_mutex;
+    tally_t         entry_counts;
+    tally_t         news_counts;
+    tally_t         pending_entries;
+    tally_t         pending_news;
+    int             ingest_count;
+    uint64_t        skipped;
+
+    /* Per-(symbol, source) tick log serving history reads; NULL if the
+       directory could not be opened (history then falls back to SQL) */
+    mc_ticks_t     *ticks;
+
+    /* Dictionary ids below this are in the strings table (rw.mutex) */
+    uint32_t        strings_persisted;
+
+    /* data_entries partitions by span start, oldest first, and the insert
+       statement for the one being written; all guarded by rw.mutex */
+    int64_t         parts[ENTRY_PARTITION_MAX];
+    int             part_count;
+    sqlite3_stmt   *part_insert;
+    int64_t         part_insert_start;
 };
 
+/* Full-text index over news. External content is a view that unpacks
+   summaries through mc_summary(), so text is stored once, compressed.
+   Triggers keep it in step with inserts and prune; the upsert only
+   touches region/country, which are not indexed. */
+static const char *NEWS_FTS_SQL =
+    "CREATE VIEW news_text AS "
+    "  SELECT id, title, mc_summary(summary_z) AS summary, source FROM news_items;"
+    "CREATE VIRTUAL TABLE news_fts USING fts5("
+    "  title, summary, source,"
+    "  content='news_text', content_rowid='id',"
+    "  tokenize='unicode61 remove_diacritics 2'"
+    ");"
+    "CREATE TRIGGER news_fts_ai AFTER INSERT ON news_items BEGIN"
+    "  INSERT INTO news_fts (rowid,title,summary,source)"
+    "  VALUES (new.id,new.title,mc_summary(new.summary_z),new.source);"
+    "END;"
+    "CREATE TRIGGER news_fts_ad AFTER DELETE ON news_items BEGIN"
+    "  INSERT INTO news_fts (news_fts,rowid,title,summary,source)"
+    "  VALUES ('delete',old.id,old.title,mc_summary(old.summary_z),old.source);"
+    "END;"
+    "CREATE TRIGGER news_fts_au AFTER UPDATE OF title,summary_z,source ON news_items BEGIN"
+    "  INSERT INTO news_fts (news_fts,rowid,title,summary,source)"
+    "  VALUES ('delete',old.id,old.title,mc_summary(old.summary_z),old.source);"
+    "  INSERT INTO news_fts (rowid,title,summary,source)"
+    "  VALUES (new.id,new.title,mc_summary(new.summary_z),new.source);"
+    "END;"
+    "INSERT INTO news_fts (news_fts) VALUES ('rebuild');";
+
+/* The first news_fts indexed news_items.summary directly */
+static const char *NEWS_FTS_DROP_SQL =
+    "DROP TRIGGER IF EXISTS news_fts_ai;"
+    "DROP TRIGGER IF EXISTS news_fts_ad;"
+    "DROP TRIGGER IF EXISTS news_fts_au;"
+    "DROP TABLE IF EXISTS news_fts;"
+    "DROP VIEW IF EXISTS news_text;";
+
 static const char *SCHEMA_SQL =
+    "PRAGMA auto_vacuum=INCREMENTAL;"   /* Takes effect at once on a new file */
     "PRAGMA journal_mode=WAL;"
     "PRAGMA foreign_keys=ON;"
 
-    "CREATE TABLE IF NOT EXISTS data_entries ("
-    "  id           INTEGER PRIMARY KEY AUTOINCREMENT,"
-    "  source_name  TEXT NOT NULL,"
-    "  source_type  INTEGER NOT NULL,"
+    "CREATE TABLE IF NOT EXISTS strings ("
+    "  id           INTEGER PRIMARY KEY,"
+    "  value        TEXT NOT NULL UNIQUE"
+    ");"
+    "INSERT OR IGNORE INTO strings (id,value) VALUES (0,'');"
+
+    "CREATE TABLE IF NOT EXISTS latest_entries ("
     "  category     INTEGER NOT NULL,"
     "  symbol       TEXT NOT NULL,"
+    "  source_name  TEXT NOT NULL,"
+    "  source_type  INTEGER NOT NULL,"
     "  display_name TEXT,"
     "  value        REAL,"
     "  currency     TEXT,"
     "  change_pct   REAL,"
     "  volume       REAL,"
     "  timestamp    INTEGER NOT NULL,"
-    "  fetched_at   INTEGER NOT NULL"
-    ");"
+    "  fetched_at   INTEGER NOT NULL,"
+    "  entry_id     INTEGER NOT NULL,"
+    "  PRIMARY KEY (category, symbol, source_name)"
+    ") WITHOUT ROWID;"
 
-    "CREATE INDEX IF NOT EXISTS idx_entries_symbol ON data_entries(symbol);"
-    "CREATE INDEX IF NOT EXISTS idx_entries_source ON data_entries(source_name);"
-    "CREATE INDEX IF NOT EXISTS idx_entries_ts     ON data_entries(timestamp DESC);"
-    "CREATE INDEX IF NOT EXISTS idx_entries_cat_sym_src_fa ON data_entries(category, symbol, source_name, fetched_at DESC);"
+    "CREATE TABLE IF NOT EXISTS candles ("
+    "  symbol       TEXT NOT NULL,"
+    "  source_name  TEXT NOT NULL,"
+    "  res          INTEGER NOT NULL,"
+    "  bucket       INTEGER NOT NULL,"
+    "  open         REAL,"
+    "  high         REAL,"
+    "  low          REAL,"
+    "  close        REAL,"
+    "  volume       REAL,"
+    "  ticks        INTEGER NOT NULL,"
+    "  PRIMARY KEY (symbol, res, bucket, source_name)"
+    ") WITHOUT ROWID;"
+    "CREATE INDEX IF NOT EXISTS idx_candles_res_bucket ON candles(res, bucket);"
 
     "CREATE TABLE IF NOT EXISTS news_items ("
     "  id           INTEGER PRIMARY KEY AUTOINCREMENT,"
     "  title        TEXT NOT NULL,"
     "  source       TEXT NOT NULL,"
     "  url          TEXT UNIQUE,"
-    "  summary      TEXT,"
+    "  summary_z    BLOB,"
     "  category     INTEGER NOT NULL,"
     "  published_at INTEGER,"
     "  fetched_at   INTEGER NOT NULL,"
@@ -53,6 +516,7 @@ static const char *SCHEMA_SQL =
 
     "CREATE INDEX IF NOT EXISTS idx_news_pub ON news_items(published_at DESC);"
     "CREATE INDEX IF NOT EXISTS idx_news_src ON news_items(source);"
+    "CREATE INDEX IF NOT EXISTS idx_news_fetched ON news_items(fetched_at);"
 
     "CREATE TABLE IF NOT EXISTS source_status ("
     "  source_name  TEXT PRIMARY KEY,"
@@ -62,154 +526,1708 @@ static const char *SCHEMA_SQL =
     "  error_count  INTEGER DEFAULT 0"
     ");";
 
-mc_db_t *mc_db_open(const char *path)
+/* mc_summary(blob) -> text, for the search index; mc_summary_pack(text)
+   -> blob, for migrating old rows */
+static void sql_summary(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+    (void)argc;
+    char text[MC_MAX_SUMMARY];
+    mc_summary_unpack(sqlite3_value_blob(argv[0]), (size_t)sqlite3_value_bytes(argv[0]),
+                      text, sizeof(text));
+    sqlite3_result_text(ctx, text, -1, SQLITE_TRANSIENT);
+}
+
+static void sql_summary_pack(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+    (void)argc;
+    unsigned char packed[MC_SUMMARY_PACK_MAX];
+    size_t plen = mc_summary_pack((const char *)sqlite3_value_text(argv[0]),
+                                  packed, sizeof(packed));
+    if (plen)
+        sqlite3_result_blob(ctx, packed, (int)plen, SQLITE_TRANSIENT);
+    else
+        sqlite3_result_null(ctx);
+}
+
+static void conn_register_functions(sqlite3 *handle)
+{
+    int flags = SQLITE_UTF8 | SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS;
+    sqlite3_create_function(handle, "mc_summary", 1, flags, NULL,
+                            sql_summary, NULL, NULL);
+    sqlite3_create_function(handle, "mc_summary_pack", 1, flags, NULL,
+                            sql_summary_pack, NULL, NULL);
+}
+
+/* Copy all of src into dst in one step. Returns an SQLite code. */
+static int backup_copy(sqlite3 *dst, sqlite3 *src)
+{
+    sqlite3_backup *b = sqlite3_backup_init(dst, "main", src, "main");
+    if (!b) return sqlite3_errcode(dst);
+    int rc = sqlite3_backup_step(b, -1);
+    int frc = sqlite3_backup_finish(b);
+    return rc == SQLITE_DONE ? frc : rc;
+}
+
+/* Seed the memdb from the on-disk file left by the last checkpoint. A
+   WAL-mode file is switched to a rollback journal first: the page 1
+   header is copied as is, and memdb cannot open a WAL database. */
+static int memory_load(mc_db_t *db)
+{
+    if (access(db->path, F_OK) != 0) return SQLITE_OK;
+
+    sqlite3 *disk;
+    int rc = sqlite3_open_v2(db->path, &disk, SQLITE_OPEN_READWRITE, NULL);
+    if (rc == SQLITE_OK) {
+        sqlite3_busy_timeout(disk, 5000);
+        rc = sqlite3_exec(disk, "PRAGMA journal_mode=DELETE;", NULL, NULL, NULL);
+    }
+    if (rc == SQLITE_OK)
+        rc = backup_copy(db->rw.handle, disk);
+    if (rc != SQLITE_OK)
+        MC_LOG_ERROR("Loading %s into memory: %s", db->path, sqlite3_errmsg(disk));
+    sqlite3_close(disk);
+    return rc;
+}
+
+static mc_db_t *db_open(const char *path, int in_memory, int checkpoint_sec)
 {
     mc_db_t *db = calloc(1, sizeof(*db));
     if (!db) return NULL;
 
-    pthread_mutex_init(&db->mutex, NULL);
-
-    int rc = sqlite3_open(path, &db->handle);
+    char uri[128];
+    snprintf(uri, sizeof(uri), "file:/mc-%d-%p?vfs=memdb", (int)getpid(), (void *)db);
+    db->path = strdup(path);
+    db->uri = strdup(in_memory ? uri : path);
+    if (!db->path || !db->uri) {
+        free(db->path);
+        free(db->uri);
+        free(db);
+        return NULL;
+    }
+    db->in_memory = in_memory;
+    db->checkpoint_sec = checkpoint_sec > 0 ? checkpoint_sec : 60;
+
+    pthread_mutex_init(&db->rw.mutex, NULL);
+    pthread_mutex_init(&db->writer_mutex, NULL);
+    pthread_mutex_init(&db->ingest_mutex, NULL);
+    pthread_mutex_init(&db->checkpoint_mutex, NULL);
+    pthread_mutex_init(&db->maint_mutex, NULL);
+    pthread_mutex_init(&db->counts_mutex, NULL);
+    pthread_cond_init(&db->checkpoint_cond, NULL);
+    sem_init(&db->writer_wake, 0, 0);
+    for (size_t i = 0; i < WRITER_QUEUE_CAP; i++)
+        atomic_init(&db->queue.cells[i].seq, i);
+
+    int rc = sqlite3_open_v2(db->uri, &db->rw.handle,
+                             SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI,
+                             NULL);
+    if (rc == SQLITE_OK && in_memory)
+        rc = memory_load(db);
     if (rc != SQLITE_OK) {
-        MC_LOG_ERROR("Failed to open DB %s: %s", path, sqlite3_errmsg(db->handle));
+        MC_LOG_ERROR("Failed to open DB %s: %s", path, sqlite3_errmsg(db->rw.handle));
+        sqlite3_close(db->rw.handle);
+        sem_destroy(&db->writer_wake);
+        pthread_cond_destroy(&db->checkpoint_cond);
+        pthread_mutex_destroy(&db->counts_mutex);
+        pthread_mutex_destroy(&db->maint_mutex);
+        pthread_mutex_destroy(&db->checkpoint_mutex);
+        pthread_mutex_destroy(&db->ingest_mutex);
+        pthread_mutex_destroy(&db->writer_mutex);
+        pthread_mutex_destroy(&db->rw.mutex);
+        free(db->uri);
+        free(db->path);
         free(db);
         return NULL;
     }
 
     /* Allow threads to wait up to 5s for DB lock instead of failing immediately */
-    sqlite3_busy_timeout(db->handle, 5000);
-
-    MC_LOG_INFO("Database opened: %s", path);
+    sqlite3_busy_timeout(db->rw.handle, 5000);
+    conn_register_functions(db->rw.handle);
+
+    char ticks_dir[1024];
+    snprintf(ticks_dir, sizeof(ticks_dir), "%s.ticks", path);
+    db->ticks = mc_ticks_open(ticks_dir);
+    if (!db->ticks)
+        MC_LOG_WARN("Tick store unavailable, history served from SQLite");
+
+    if (in_memory)
+        MC_LOG_INFO("Database opened in memory: %s (checkpoint every %d s)",
+                    path, db->checkpoint_sec);
+    else
+        MC_LOG_INFO("Database opened: %s", path);
     return db;
 }
 
-void mc_db_close(mc_db_t *db)
+mc_db_t *mc_db_open(const char *path)
+{
+    return db_open(path, 0, 0);
+}
+
+mc_db_t *mc_db_open_memory(const char *path, int checkpoint_sec)
+{
+    return db_open(path, 1, checkpoint_sec);
+}
+
+/* Fetch a cached statement, compiling it on first use if mc_db_migrate()
+   has not prepared it yet. Caller must hold c->mutex. */
+static sqlite3_stmt *stmt_get(db_conn_t *c, stmt_id_t id)
+{
+    if (!c->stmts[id]) {
+        int rc = sqlite3_prepare_v3(c->handle, STMT_SQL[id], -1,
+                                    SQLITE_PREPARE_PERSISTENT,
+                                    &c->stmts[id], NULL);
+        if (rc != SQLITE_OK) {
+            MC_LOG_ERROR("Prepare statement %d: %s", id, sqlite3_errmsg(c->handle));
+            c->stmts[id] = NULL;
+        }
+    }
+    return c->stmts[id];
+}
+
+/* Return a statement to the cache: reset it and drop bindings so no
+   SQLITE_STATIC pointer outlives the caller's buffers. */
+static void stmt_release(sqlite3_stmt *stmt)
+{
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+}
+
+static void stmts_finalize(db_conn_t *c)
+{
+    for (int i = 0; i < STMT_COUNT; i++) {
+        sqlite3_finalize(c->stmts[i]);
+        c->stmts[i] = NULL;
+    }
+}
+
+static void conn_close(db_conn_t *c)
+{
+    pthread_mutex_lock(&c->mutex);
+    stmts_finalize(c);
+    sqlite3_close(c->handle);
+    c->handle = NULL;
+    pthread_mutex_unlock(&c->mutex);
+    pthread_mutex_destroy(&c->mutex);
+}
+
+/* Open the read-only pool. Done after migration so the schema and WAL
+   mode exist; a reader that fails to open just shrinks the pool. */
+static void readers_open(mc_db_t *db)
+{
+    while (db->reader_count < DB_READ_POOL_SIZE) {
+        db_conn_t *c = &db->readers[db->reader_count];
+        int rc = sqlite3_open_v2(db->uri, &c->handle,
+                                 SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX |
+                                 SQLITE_OPEN_URI, NULL);
+        if (rc != SQLITE_OK) {
+            MC_LOG_WARN("Read-only connection %d failed: %s", db->reader_count,
+                        sqlite3_errmsg(c->handle));
+            sqlite3_close(c->handle);
+            c->handle = NULL;
+            break;
+        }
+        sqlite3_busy_timeout(c->handle, 5000);
+        conn_register_functions(c->handle);
+        pthread_mutex_init(&c->mutex, NULL);
+        db->reader_count++;
+    }
+    MC_LOG_INFO("Database read pool: %d connections", db->reader_count);
+}
+
+/* Pick an idle reader (round-robin start), or wait on the next one if all
+   are busy. Falls back to the read-write connection if no pool exists. */
+static db_conn_t *reader_acquire(mc_db_t *db)
+{
+    if (db->reader_count == 0) {
+        pthread_mutex_lock(&db->rw.mutex);
+        return &db->rw;
+    }
+
+    unsigned start = atomic_fetch_add(&db->reader_next, 1);
+    for (int i = 0; i < db->reader_count; i++) {
+        db_conn_t *c = &db->readers[(start + (unsigned)i) % (unsigned)db->reader_count];
+        if (pthread_mutex_trylock(&c->mutex) == 0)
+            return c;
+    }
+
+    db_conn_t *c = &db->readers[start % (unsigned)db->reader_count];
+    pthread_mutex_lock(&c->mutex);
+    return c;
+}
+
+static void reader_release(db_conn_t *c)
+{
+    pthread_mutex_unlock(&c->mutex);
+}
+
+static void writer_stop(mc_db_t *db);
+static void checkpoint_stop(mc_db_t *db);
+
+void mc_db_close(mc_db_t *db)
+{
+    if (!db) return;
+    writer_stop(db);
+    checkpoint_stop(db);
+    mc_ticks_close(db->ticks);
+
+    sqlite3_finalize(db->part_insert);
+    for (int i = 0; i < db->reader_count; i++)
+        conn_close(&db->readers[i]);
+    sqlite3_close(db->maint);
+    conn_close(&db->rw);
+    free(db->quotes);
+    free(db->entry_counts.slots);
+    free(db->news_counts.slots);
+    free(db->pending_entries.slots);
+    free(db->pending_news.slots);
+    pthread_cond_destroy(&db->checkpoint_cond);
+    pthread_mutex_destroy(&db->counts_mutex);
+    pthread_mutex_destroy(&db->maint_mutex);
+    pthread_mutex_destroy(&db->checkpoint_mutex);
+    pthread_mutex_destroy(&db->ingest_mutex);
+    pthread_mutex_destroy(&db->writer_mutex);
+    sem_destroy(&db->writer_wake);
+    free(db->uri);
+    free(db->path);
+    free(db);
+}
+
+static uint32_t hash_u64(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (uint32_t)key;
+}
+
+static uint64_t tally_key(uint32_t source_id, int category)
+{
+    return (uint64_t)source_id << 8 | (uint8_t)category;
+}
+
+/* Returns -1 only if the table cannot grow (the delta is then lost) */
+static int tally_add(tally_t *t, uint64_t key, int64_t rows)
+{
+    if ((t->used + 1) * 2 > t->cap) {
+        uint32_t cap = t->cap ? t->cap * 2 : 256;
+        tally_slot_t *slots = malloc(cap * sizeof(*slots));
+        if (!slots) return -1;
+        memset(slots, 0xff, cap * sizeof(*slots));
+        for (uint32_t i = 0; i < t->cap; i++) {
+            if (t->slots[i].key == UINT64_MAX) continue;
+            uint32_t h = hash_u64(t->slots[i].key) & (cap - 1);
+            while (slots[h].key != UINT64_MAX) h = (h + 1) & (cap - 1);
+            slots[h] = t->slots[i];
+        }
+        free(t->slots);
+        t->slots = slots;
+        t->cap = cap;
+    }
+
+    uint32_t mask = t->cap - 1;
+    uint32_t h = hash_u64(key) & mask;
+    while (t->slots[h].key != key && t->slots[h].key != UINT64_MAX)
+        h = (h + 1) & mask;
+    if (t->slots[h].key == UINT64_MAX) {
+        t->slots[h].key = key;
+        t->slots[h].rows = 0;
+        t->used++;
+    }
+    t->slots[h].rows += rows;
+    t->total += rows;
+    return 0;
+}
+
+static void tally_clear(tally_t *t)
+{
+    if (t->used == 0) return;
+    memset(t->slots, 0xff, t->cap * sizeof(*t->slots));
+    t->used = 0;
+    t->total = 0;
+}
+
+/* Fold a transaction's deltas into the live counts, or drop them if it
+   rolled back. Caller must hold db->rw.mutex (which guards pending_*). */
+static void counts_commit(mc_db_t *db, int committed)
+{
+    tally_t *pending[2] = { &db->pending_entries, &db->pending_news };
+    tally_t *live[2] = { &db->entry_counts, &db->news_counts };
+
+    if (committed) pthread_mutex_lock(&db->counts_mutex);
+    for (int k = 0; k < 2; k++) {
+        for (uint32_t i = 0; committed && i < pending[k]->cap; i++)
+            if (pending[k]->slots[i].key != UINT64_MAX)
+                tally_add(live[k], pending[k]->slots[i].key, pending[k]->slots[i].rows);
+        tally_clear(pending[k]);
+    }
+    if (committed) pthread_mutex_unlock(&db->counts_mutex);
+}
+
+/* Add the (source, category, rows) groups a query returns; column 0 is
+   either a dictionary id or source text */
+static int tally_query(sqlite3 *handle, const char *sql, tally_t *t, int sign)
+{
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(handle, sql, -1, &stmt, NULL) != SQLITE_OK)
+        return SQLITE_ERROR;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        uint32_t source_id = sqlite3_column_type(stmt, 0) == SQLITE_TEXT
+            ? mc_intern((const char *)sqlite3_column_text(stmt, 0))
+            : (uint32_t)sqlite3_column_int64(stmt, 0);
+        tally_add(t, tally_key(source_id, sqlite3_column_int(stmt, 1)),
+                  sign * sqlite3_column_int64(stmt, 2));
+    }
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? SQLITE_OK : rc;
+}
+
+static void part_name(int64_t start, char *out, size_t size)
+{
+    snprintf(out, size, "data_entries_%lld", (long long)start);
+}
+
+/* Read the partition list back from the schema: at startup, or after a
+   rollback undid partition DDL. Fails rather than leave partitions past
+   ENTRY_PARTITION_MAX out of the view and of retention.
+   Caller must hold db->rw.mutex. */
+static int parts_load(mc_db_t *db)
+{
+    sqlite3_finalize(db->part_insert);
+    db->part_insert = NULL;
+    db->part_count = 0;
+
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db->rw.handle,
+            "SELECT CAST(substr(name,14) AS INTEGER) FROM sqlite_master "
+            "WHERE type='table' AND name GLOB 'data_entries_[0-9]*' ORDER BY 1",
+            -1, &stmt, NULL) != SQLITE_OK) {
+        MC_LOG_ERROR("List entry partitions: %s", sqlite3_errmsg(db->rw.handle));
+        return SQLITE_ERROR;
+    }
+    int found = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        if (found++ < ENTRY_PARTITION_MAX)
+            db->parts[db->part_count++] = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    if (found > ENTRY_PARTITION_MAX) {
+        MC_LOG_ERROR("%d entry partitions exceed the limit of %d",
+                     found, ENTRY_PARTITION_MAX);
+        return SQLITE_FULL;
+    }
+    return SQLITE_OK;
+}
+
+/* Point the data_entries view at the current partitions (at least one).
+   Caller must hold db->rw.mutex. */
+static int view_rebuild(mc_db_t *db)
+{
+    size_t cap = 128 + (size_t)db->part_count * (sizeof(ENTRY_VIEW_SELECT) + 64);
+    char *sql = malloc(cap);
+    if (!sql) return SQLITE_NOMEM;
+
+    size_t n = (size_t)snprintf(sql, cap,
+        "DROP VIEW IF EXISTS data_entries;CREATE VIEW data_entries AS ");
+    for (int i = 0; i < db->part_count; i++) {
+        char name[64];
+        part_name(db->parts[i], name, sizeof(name));
+        if (i) n += (size_t)snprintf(sql + n, cap - n, " UNION ALL ");
+        n += (size_t)snprintf(sql + n, cap - n, ENTRY_VIEW_SELECT, name);
+    }
+
+    int rc = sqlite3_exec(db->rw.handle, sql, NULL, NULL, NULL);
+    if (rc != SQLITE_OK)
+        MC_LOG_ERROR("Rebuild data_entries view: %s", sqlite3_errmsg(db->rw.handle));
+    free(sql);
+    return rc;
+}
+
+/* Caller must hold db->rw.mutex */
+static int part_create(mc_db_t *db, int64_t start)
+{
+    if (db->part_count == ENTRY_PARTITION_MAX) {
+        MC_LOG_ERROR("Entry partition limit (%d) reached", ENTRY_PARTITION_MAX);
+        return SQLITE_FULL;
+    }
+
+    char name[64], sql[2048];
+    part_name(start, name, sizeof(name));
+    snprintf(sql, sizeof(sql), ENTRY_PARTITION_DDL, name, name, name, name);
+    int rc = sqlite3_exec(db->rw.handle, sql, NULL, NULL, NULL);
+    if (rc != SQLITE_OK) {
+        MC_LOG_ERROR("Create partition %s: %s", name, sqlite3_errmsg(db->rw.handle));
+        return rc;
+    }
+
+    int i = db->part_count++;
+    while (i > 0 && db->parts[i - 1] > start) {
+        db->parts[i] = db->parts[i - 1];
+        i--;
+    }
+    db->parts[i] = start;
+    return view_rebuild(db);
+}
+
+/* Persist strings interned since the last commit, inside the caller's
+   transaction. Returns the id count now covered; the caller records it in
+   strings_persisted once the transaction commits. Caller must hold
+   db->rw.mutex. */
+static uint32_t strings_flush(mc_db_t *db)
+{
+    uint32_t n = mc_intern_count();
+    if (db->strings_persisted >= n) return db->strings_persisted;
+
+    sqlite3_stmt *stmt = stmt_get(&db->rw, STMT_INSERT_STRING);
+    if (!stmt) return db->strings_persisted;
+
+    for (uint32_t id = db->strings_persisted; id < n; id++) {
+        sqlite3_bind_int64(stmt, 1, id);
+        sqlite3_bind_text(stmt, 2, mc_intern_str(id), -1, SQLITE_STATIC);
+        if (sqlite3_step(stmt) != SQLITE_DONE)
+            MC_LOG_ERROR("Insert string %u: %s", id, sqlite3_errmsg(db->rw.handle));
+        stmt_release(stmt);
+    }
+    return n;
+}
+
+/* Seed the in-process intern table from the strings dictionary so ids
+   stored in partitions resolve the same way. Caller must hold rw.mutex. */
+static int strings_load(mc_db_t *db)
+{
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db->rw.handle, "SELECT id,value FROM strings ORDER BY id",
+                           -1, &stmt, NULL) != SQLITE_OK) {
+        MC_LOG_ERROR("Load strings: %s", sqlite3_errmsg(db->rw.handle));
+        return SQLITE_ERROR;
+    }
+
+    int rc = SQLITE_OK;
+    uint32_t loaded = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        uint32_t id = (uint32_t)sqlite3_column_int64(stmt, 0);
+        const char *value = (const char *)sqlite3_column_text(stmt, 1);
+        if (mc_intern_restore(id, value ? value : "") != 0) {
+            MC_LOG_ERROR("String id %u conflicts with the in-process dictionary", id);
+            rc = SQLITE_ERROR;
+            break;
+        }
+        loaded = id + 1;
+    }
+    sqlite3_finalize(stmt);
+
+    db->strings_persisted = loaded;
+    return rc;
+}
+
+/* Migration: rewrite a partition created before interning, moving its
+   text columns into the dictionary. Caller must hold db->rw.mutex. */
+static int part_intern(mc_db_t *db, const char *name)
+{
+    char sql[4096];
+    sqlite3_stmt *stmt;
+    snprintf(sql, sizeof(sql),
+             "SELECT source_name FROM %s UNION SELECT symbol FROM %s "
+             "UNION SELECT display_name FROM %s UNION SELECT currency FROM %s",
+             name, name, name, name);
+    if (sqlite3_prepare_v2(db->rw.handle, sql, -1, &stmt, NULL) != SQLITE_OK) {
+        MC_LOG_ERROR("Intern partition %s: %s", name, sqlite3_errmsg(db->rw.handle));
+        return SQLITE_ERROR;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+        mc_intern((const char *)sqlite3_column_text(stmt, 0));
+    sqlite3_finalize(stmt);
+
+    int rc = sqlite3_exec(db->rw.handle, "BEGIN IMMEDIATE", NULL, NULL, NULL);
+    if (rc != SQLITE_OK) return rc;
+    uint32_t persisted = strings_flush(db);
+
+    int n = snprintf(sql, sizeof(sql),
+        "DROP VIEW IF EXISTS data_entries;"
+        "ALTER TABLE %s RENAME TO data_entries_text;"
+        "DROP INDEX IF EXISTS idx_%s_symbol;", name, name);
+    n += snprintf(sql + n, sizeof(sql) - (size_t)n, ENTRY_PARTITION_DDL,
+                  name, name, name, name);
+    snprintf(sql + n, sizeof(sql) - (size_t)n,
+        "INSERT INTO %s (id,source_id,source_type,category,symbol_id,display_id,"
+        "value,currency_id,change_pct,volume,timestamp,fetched_at) "
+        "SELECT o.id,"
+        "(SELECT id FROM strings WHERE value=o.source_name),o.source_type,o.category,"
+        "(SELECT id FROM strings WHERE value=o.symbol),"
+        "(SELECT id FROM strings WHERE value=coalesce(o.display_name,'')),o.value,"
+        "(SELECT id FROM strings WHERE value=coalesce(o.currency,'')),"
+        "o.change_pct,o.volume,o.timestamp,o.fetched_at FROM data_entries_text o;"
+        "DROP TABLE data_entries_text;", name);
+
+    rc = sqlite3_exec(db->rw.handle, sql, NULL, NULL, NULL);
+    if (rc == SQLITE_OK)
+        rc = sqlite3_exec(db->rw.handle, "COMMIT", NULL, NULL, NULL);
+    if (rc != SQLITE_OK) {
+        MC_LOG_ERROR("Intern partition %s: %s", name, sqlite3_errmsg(db->rw.handle));
+        sqlite3_exec(db->rw.handle, "ROLLBACK", NULL, NULL, NULL);
+        return rc;
+    }
+
+    db->strings_persisted = persisted;
+    MC_LOG_INFO("Interned strings of partition %s", name);
+    return SQLITE_OK;
+}
+
+/* type is 'table', 'view', ...; name a schema object, or for 'column'
+   "table.column" */
+static int schema_has(sqlite3 *handle, const char *type, const char *name)
+{
+    sqlite3_stmt *stmt;
+    int found = 0;
+    const char *dot = strcmp(type, "column") == 0 ? strchr(name, '.') : NULL;
+    const char *sql = dot
+        ? "SELECT 1 FROM pragma_table_info(substr(?2,1,?3)) WHERE name=substr(?2,?3+2)"
+        : "SELECT 1 FROM sqlite_master WHERE type=?1 AND name=?2";
+    if (sqlite3_prepare_v2(handle, sql, -1, &stmt, NULL) == SQLITE_OK) {
+        if (!dot) sqlite3_bind_text(stmt, 1, type, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, name, -1, SQLITE_STATIC);
+        if (dot) sqlite3_bind_int(stmt, 3, (int)(dot - name));
+        found = sqlite3_step(stmt) == SQLITE_ROW;
+        sqlite3_finalize(stmt);
+    }
+    return found;
+}
+
+/* Value of a single-row PRAGMA such as "PRAGMA auto_vacuum", -1 on error */
+static int pragma_int(sqlite3 *handle, const char *sql)
+{
+    sqlite3_stmt *stmt;
+    int value = -1;
+    if (sqlite3_prepare_v2(handle, sql, -1, &stmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW)
+            value = sqlite3_column_int(stmt, 0);
+        sqlite3_finalize(stmt);
+    }
+    return value;
+}
+
+/* Migration: the pre-partitioning data_entries table becomes the partition
+   covering its newest row, so it ages out like any other. Text partitions
+   are converted to dictionary ids. Then make sure the view exists over at
+   least one partition. */
+static int entries_partition_migrate(mc_db_t *db)
+{
+    sqlite3_stmt *stmt;
+    int legacy = schema_has(db->rw.handle, "table", "data_entries");
+    int64_t newest = -1;
+
+    if (legacy && sqlite3_prepare_v2(db->rw.handle,
+            "SELECT max(fetched_at) FROM data_entries", -1, &stmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW &&
+            sqlite3_column_type(stmt, 0) != SQLITE_NULL)
+            newest = sqlite3_column_int64(stmt, 0);
+        sqlite3_finalize(stmt);
+    }
+
+    int rc = SQLITE_OK;
+    if (legacy && newest < 0) {
+        rc = sqlite3_exec(db->rw.handle, "DROP TABLE data_entries;", NULL, NULL, NULL);
+    } else if (legacy) {
+        char name[64], sql[512];
+        part_name(newest - newest % ENTRY_PARTITION_SEC, name, sizeof(name));
+        snprintf(sql, sizeof(sql),
+                 "ALTER TABLE data_entries RENAME TO %s;"
+                 "DROP INDEX IF EXISTS idx_entries_source;"
+                 "DROP INDEX IF EXISTS idx_entries_ts;", name);
+        rc = sqlite3_exec(db->rw.handle, sql, NULL, NULL, NULL);
+        if (rc == SQLITE_OK)
+            MC_LOG_INFO("Migrated data_entries to partition %s", name);
+    }
+    if (rc != SQLITE_OK) {
+        MC_LOG_ERROR("Partition data_entries: %s", sqlite3_errmsg(db->rw.handle));
+        return rc;
+    }
+
+    if ((rc = strings_load(db)) != SQLITE_OK || (rc = parts_load(db)) != SQLITE_OK)
+        return rc;
+
+    /* Partitions written before interning still hold text columns */
+    for (int i = 0; i < db->part_count; i++) {
+        char name[64], sql[256];
+        part_name(db->parts[i], name, sizeof(name));
+        snprintf(sql, sizeof(sql),
+                 "SELECT 1 FROM pragma_table_info('%s') WHERE name='symbol_id'", name);
+        int interned = 0;
+        if (sqlite3_prepare_v2(db->rw.handle, sql, -1, &stmt, NULL) == SQLITE_OK) {
+            interned = sqlite3_step(stmt) == SQLITE_ROW;
+            sqlite3_finalize(stmt);
+        }
+        if (!interned && (rc = part_intern(db, name)) != SQLITE_OK)
+            return rc;
+    }
+
+    if (db->part_count == 0) {
+        time_t now = time(NULL);
+        return part_create(db, (int64_t)(now - now % ENTRY_PARTITION_SEC));
+    }
+    return view_rebuild(db);
+}
+
+static mc_error_t writer_start(mc_db_t *db);
+static void checkpoint_start(mc_db_t *db);
+static void maint_open(mc_db_t *db);
+
+mc_error_t mc_db_migrate(mc_db_t *db)
+{
+    pthread_mutex_lock(&db->rw.mutex);
+    char *err = NULL;
+    int rc = sqlite3_exec(db->rw.handle, SCHEMA_SQL, NULL, NULL, &err);
+    pthread_mutex_unlock(&db->rw.mutex);
+
+    if (rc != SQLITE_OK) {
+        MC_LOG_ERROR("Migration failed: %s", err ? err : "unknown");
+        sqlite3_free(err);
+        return MC_ERR_DB;
+    }
+
+    /* Migration: add base_score column if missing (ignore error = already exists) */
+    err = NULL;
+    sqlite3_exec(db->rw.handle,
+        "ALTER TABLE news_items ADD COLUMN base_score REAL DEFAULT 50.0;",
+        NULL, NULL, &err);
+    if (err) sqlite3_free(err);
+
+    /* Migration: add region/country columns if missing */
+    err = NULL;
+    sqlite3_exec(db->rw.handle,
+        "ALTER TABLE news_items ADD COLUMN region TEXT DEFAULT '';",
+        NULL, NULL, &err);
+    if (err) sqlite3_free(err);
+
+    err = NULL;
+    sqlite3_exec(db->rw.handle,
+        "ALTER TABLE news_items ADD COLUMN country TEXT DEFAULT '';",
+        NULL, NULL, &err);
+    if (err) sqlite3_free(err);
+
+    /* Migration: summaries move to packed summary_z. The search index
+       reads through news_text, so an index built over the old column is
+       dropped first and rebuilt once the rows are converted. */
+    err = NULL;
+    sqlite3_exec(db->rw.handle,
+        "ALTER TABLE news_items ADD COLUMN summary_z BLOB;",
+        NULL, NULL, &err);
+    if (err) sqlite3_free(err);
+
+    int fts_ready = schema_has(db->rw.handle, "view", "news_text");
+    err = NULL;
+    rc = SQLITE_OK;
+    if (!fts_ready)
+        rc = sqlite3_exec(db->rw.handle, NEWS_FTS_DROP_SQL, NULL, NULL, &err);
+    if (rc == SQLITE_OK && schema_has(db->rw.handle, "column", "news_items.summary")) {
+        MC_LOG_INFO("Compressing stored news summaries");
+        rc = sqlite3_exec(db->rw.handle,
+            "UPDATE news_items SET summary_z=mc_summary_pack(summary) "
+            "WHERE summary IS NOT NULL AND summary != '';"
+            "ALTER TABLE news_items DROP COLUMN summary;",
+            NULL, NULL, &err);
+    }
+    if (rc == SQLITE_OK && !fts_ready)
+        rc = sqlite3_exec(db->rw.handle, NEWS_FTS_SQL, NULL, NULL, &err);
+    if (rc != SQLITE_OK) {
+        MC_LOG_ERROR("News summary migration failed: %s", err ? err : "unknown");
+        sqlite3_free(err);
+        return MC_ERR_DB;
+    }
+
+    pthread_mutex_lock(&db->rw.mutex);
+    rc = entries_partition_migrate(db);
+    pthread_mutex_unlock(&db->rw.mutex);
+    if (rc != SQLITE_OK)
+        return MC_ERR_DB;
+
+    /* Migration: seed latest_entries from history once, then drop the
+       index that only served the old ROW_NUMBER() scan */
+    err = NULL;
+    rc = sqlite3_exec(db->rw.handle,
+        "INSERT OR IGNORE INTO latest_entries "
+        "(category,symbol,source_name,source_type,display_name,value,"
+        "currency,change_pct,volume,timestamp,fetched_at,entry_id) "
+        "SELECT category,symbol,source_name,source_type,display_name,value,"
+        "currency,change_pct,volume,timestamp,fetched_at,id FROM ("
+        "  SELECT *, ROW_NUMBER() OVER ("
+        "    PARTITION BY category,symbol,source_name ORDER BY fetched_at DESC"
+        "  ) AS rn FROM data_entries"
+        "  WHERE NOT EXISTS (SELECT 1 FROM latest_entries)"
+        ") WHERE rn=1;"
+        "DROP INDEX IF EXISTS idx_entries_cat_sym_src_fa;",
+        NULL, NULL, &err);
+    if (rc != SQLITE_OK) {
+        MC_LOG_ERROR("Seeding latest_entries failed: %s", err ? err : "unknown");
+        sqlite3_free(err);
+        return MC_ERR_DB;
+    }
+
+    /* Compile the hot-path statements now that the schema is final */
+    pthread_mutex_lock(&db->rw.mutex);
+    stmts_finalize(&db->rw);
+    int prepared = 0;
+    for (int i = 0; i < STMT_COUNT; i++)
+        if (stmt_get(&db->rw, i)) prepared++;
+    pthread_mutex_unlock(&db->rw.mutex);
+
+    if (prepared != STMT_COUNT) {
+        MC_LOG_ERROR("Prepared %d/%d statements", prepared, STMT_COUNT);
+        return MC_ERR_DB;
+    }
+
+    /* Migration: auto_vacuum only changes on an existing file through a
+       full VACUUM, done once here while no other connection is open */
+    if (pragma_int(db->rw.handle, "PRAGMA auto_vacuum") != 2) {
+        MC_LOG_INFO("Enabling incremental vacuum (one-time VACUUM)");
+        err = NULL;
+        if (sqlite3_exec(db->rw.handle, "PRAGMA auto_vacuum=INCREMENTAL; VACUUM;",
+                         NULL, NULL, &err) != SQLITE_OK) {
+            MC_LOG_WARN("VACUUM failed, pruned pages stay in the file: %s",
+                        err ? err : "unknown");
+            sqlite3_free(err);
+        }
+    }
+    sqlite3_wal_autocheckpoint(db->rw.handle, WAL_AUTOCHECKPOINT_PAGES);
+
+    if (db->reader_count == 0)
+        readers_open(db);
+
+    /* Seed the row counters once; from here on the writer and pruning
+       keep them current */
+    pthread_mutex_lock(&db->rw.mutex);
+    pthread_mutex_lock(&db->counts_mutex);
+    tally_clear(&db->entry_counts);
+    tally_clear(&db->news_counts);
+    rc = tally_query(db->rw.handle,
+        "SELECT source,category,count(*) FROM news_items GROUP BY 1,2",
+        &db->news_counts, 1);
+    for (int i = 0; rc == SQLITE_OK && i < db->part_count; i++) {
+        char name[64], sql[160];
+        part_name(db->parts[i], name, sizeof(name));
+        snprintf(sql, sizeof(sql),
+                 "SELECT source_id,category,count(*) FROM %s GROUP BY 1,2", name);
+        rc = tally_query(db->rw.handle, sql, &db->entry_counts, 1);
+    }
+    pthread_mutex_unlock(&db->counts_mutex);
+    pthread_mutex_unlock(&db->rw.mutex);
+    if (rc != SQLITE_OK)
+        MC_LOG_WARN("Counting rows failed, status counts are partial: %s",
+                    sqlite3_errmsg(db->rw.handle));
+
+    if (db->maint == NULL)
+        maint_open(db);
+
+    if (writer_start(db) != MC_OK)
+        return MC_ERR_THREAD;
+    checkpoint_start(db);
+
+    MC_LOG_INFO("Database migration complete");
+    return MC_OK;
+}
+
+/* Run a parameterless cached statement (BEGIN/COMMIT/ROLLBACK).
+   Caller must hold c->mutex. */
+static int stmt_exec(db_conn_t *c, stmt_id_t id)
+{
+    sqlite3_stmt *stmt = stmt_get(c, id);
+    if (!stmt) return SQLITE_ERROR;
+    int rc = sqlite3_step(stmt);
+    stmt_release(stmt);
+    return rc;
+}
+
+static void bind_entry(sqlite3_stmt *stmt, const void *row)
+{
+    const mc_data_entry_t *e = row;
+    sqlite3_bind_text(stmt, 1, e->source_name, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, e->source_type);
+    sqlite3_bind_int(stmt, 3, e->category);
+    sqlite3_bind_text(stmt, 4, e->symbol, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 5, e->display_name, -1, SQLITE_STATIC);
+    sqlite3_bind_double(stmt, 6, e->value);
+    sqlite3_bind_text(stmt, 7, e->currency, -1, SQLITE_STATIC);
+    sqlite3_bind_double(stmt, 8, e->change_pct);
+    sqlite3_bind_double(stmt, 9, e->volume);
+    sqlite3_bind_int64(stmt, 10, e->timestamp);
+    sqlite3_bind_int64(stmt, 11, e->fetched_at);
+}
+
+/* Partition rows: bind_entry's layout with dictionary ids for strings */
+static void bind_entry_interned(sqlite3_stmt *stmt, const void *row)
+{
+    const mc_data_entry_t *e = row;
+    sqlite3_bind_int64(stmt, 1, mc_intern(e->source_name));
+    sqlite3_bind_int(stmt, 2, e->source_type);
+    sqlite3_bind_int(stmt, 3, e->category);
+    sqlite3_bind_int64(stmt, 4, mc_intern(e->symbol));
+    sqlite3_bind_int64(stmt, 5, mc_intern(e->display_name));
+    sqlite3_bind_double(stmt, 6, e->value);
+    sqlite3_bind_int64(stmt, 7, mc_intern(e->currency));
+    sqlite3_bind_double(stmt, 8, e->change_pct);
+    sqlite3_bind_double(stmt, 9, e->volume);
+    sqlite3_bind_int64(stmt, 10, e->timestamp);
+    sqlite3_bind_int64(stmt, 11, e->fetched_at);
+}
+
+static void bind_news(sqlite3_stmt *stmt, const void *row)
+{
+    const mc_news_item_t *item = row;
+    unsigned char packed[MC_SUMMARY_PACK_MAX];
+    size_t plen = mc_summary_pack(item->summary, packed, sizeof(packed));
+
+    sqlite3_bind_text(stmt, 1, item->title, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, item->source, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, item->url, -1, SQLITE_STATIC);
+    if (plen)
+        sqlite3_bind_blob(stmt, 4, packed, (int)plen, SQLITE_TRANSIENT);
+    else
+        sqlite3_bind_null(stmt, 4);
+    sqlite3_bind_int(stmt, 5, item->category);
+    sqlite3_bind_int64(stmt, 6, item->published_at);
+    sqlite3_bind_int64(stmt, 7, item->fetched_at);
+    sqlite3_bind_double(stmt, 8, item->score);
+    sqlite3_bind_text(stmt, 9, item->region, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 10, item->country, -1, SQLITE_STATIC);
+}
+
+static void bind_status(sqlite3_stmt *stmt, const void *row)
+{
+    const status_row_t *st = row;
+    sqlite3_bind_text(stmt, 1, st->source_name, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, st->type);
+    sqlite3_bind_int64(stmt, 3, st->at);
+    if (st->has_error)
+        sqlite3_bind_text(stmt, 4, st->error, -1, SQLITE_STATIC);
+    else
+        sqlite3_bind_null(stmt, 4);
+    sqlite3_bind_int(stmt, 5, st->has_error);
+}
+
+static void bind_touch(sqlite3_stmt *stmt, const void *row)
+{
+    const touch_row_t *t = row;
+    sqlite3_bind_int64(stmt, 1, t->at);
+    sqlite3_bind_text(stmt, 2, t->source_name, -1, SQLITE_STATIC);
+}
+
+/* Run a cached write statement on rw, logging failures */
+static void step_logged(mc_db_t *db, sqlite3_stmt *stmt, const char *what)
+{
+    if (sqlite3_step(stmt) != SQLITE_DONE)
+        MC_LOG_ERROR("%s failed: %s", what, sqlite3_errmsg(db->rw.handle));
+    stmt_release(stmt);
+}
+
+/* Derived state for a stored entry: the latest-value row and one candle
+   per resolution. Runs right after the history insert. */
+static void entry_after_insert(mc_db_t *db, const void *row)
+{
+    const mc_data_entry_t *e = row;
+
+    sqlite3_stmt *stmt = stmt_get(&db->rw, STMT_UPSERT_LATEST_ENTRY);
+    if (stmt) {
+        bind_entry(stmt, e);
+        step_logged(db, stmt, "Update latest entry");
+    }
+
+    stmt = stmt_get(&db->rw, STMT_UPSERT_CANDLE);
+    if (!stmt) return;
+    for (int i = 0; i < CANDLE_RES_COUNT; i++) {
+        sqlite3_bind_text(stmt, 1, e->symbol, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, e->source_name, -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 3, CANDLE_RES[i].sec);
+        sqlite3_bind_int64(stmt, 4, e->timestamp - e->timestamp % CANDLE_RES[i].sec);
+        sqlite3_bind_double(stmt, 5, e->value);
+        sqlite3_bind_double(stmt, 6, e->volume);
+        step_logged(db, stmt, "Update candle");
+    }
+}
+
+/* Insert statement for the partition covering the entry, creating the
+   partition when fetched_at enters a new span. Caller must hold
+   db->rw.mutex. */
+static sqlite3_stmt *entry_insert_stmt(mc_db_t *db, const void *row)
+{
+    const mc_data_entry_t *e = row;
+    int64_t start = (int64_t)e->fetched_at - (int64_t)e->fetched_at % ENTRY_PARTITION_SEC;
+    if (db->part_insert && db->part_insert_start == start)
+        return db->part_insert;
+
+    int exists = 0;
+    for (int i = db->part_count - 1; i >= 0 && !exists; i--)
+        exists = db->parts[i] == start;
+    if (!exists && part_create(db, start) != SQLITE_OK)
+        return NULL;
+
+    char name[64], sql[512];
+    part_name(start, name, sizeof(name));
+    snprintf(sql, sizeof(sql), ENTRY_SEQ_LIFT_SQL, name);
+    if (sqlite3_exec(db->rw.handle, sql, NULL, NULL, NULL) != SQLITE_OK)
+        MC_LOG_WARN("Lift id sequence of %s: %s", name, sqlite3_errmsg(db->rw.handle));
+    snprintf(sql, sizeof(sql), ENTRY_INSERT_SQL, name);
+
+    sqlite3_finalize(db->part_insert);
+    db->part_insert = NULL;
+    if (sqlite3_prepare_v3(db->rw.handle, sql, -1, SQLITE_PREPARE_PERSISTENT,
+                           &db->part_insert, NULL) != SQLITE_OK) {
+        MC_LOG_ERROR("Prepare insert into %s: %s", name, sqlite3_errmsg(db->rw.handle));
+        sqlite3_finalize(db->part_insert);
+        db->part_insert = NULL;
+        return NULL;
+    }
+    db->part_insert_start = start;
+    return db->part_insert;
+}
+
+static void entry_count(mc_db_t *db, const void *row)
+{
+    const mc_data_entry_t *e = row;
+    tally_add(&db->pending_entries, tally_key(mc_intern(e->source_name), e->category), 1);
+}
+
+static void news_count(mc_db_t *db, const void *row)
+{
+    const mc_news_item_t *item = row;
+    tally_add(&db->pending_news, tally_key(mc_intern(item->source), item->category), 1);
+}
+
+/* target: picks the statement per row when the destination table varies
+   (stmt is then unused). count: optional hook for each row inserted, not
+   upserted into an existing one. after: optional hook for each row written. */
+static const struct {
+    stmt_id_t   stmt;
+    sqlite3_stmt *(*target)(mc_db_t *, const void *);
+    size_t      row_size;
+    void      (*bind)(sqlite3_stmt *, const void *);
+    void      (*count)(mc_db_t *, const void *);
+    void      (*after)(mc_db_t *, const void *);
+    const char *what;
+} JOB_KINDS[] = {
+    [JOB_ENTRIES]       = { STMT_COUNT, entry_insert_stmt, sizeof(mc_data_entry_t), bind_entry_interned, entry_count, entry_after_insert, "entry" },
+    [JOB_NEWS]          = { STMT_INSERT_NEWS, NULL, sizeof(mc_news_item_t), bind_news, news_count, NULL, "news" },
+    [JOB_SOURCE_STATUS] = { STMT_UPDATE_SOURCE_STATUS, NULL, sizeof(status_row_t), bind_status, NULL, NULL, "source status" },
+    [JOB_TOUCH_ENTRIES] = { STMT_TOUCH_LATEST_ENTRIES, NULL, sizeof(touch_row_t), bind_touch, NULL, NULL, "entry touch" },
+    [JOB_TOUCH_NEWS]    = { STMT_TOUCH_NEWS, NULL, sizeof(touch_row_t), bind_touch, NULL, NULL, "news touch" },
+};
+
+/* Write one job's rows inside the caller's transaction. A failing row is
+   logged and skipped so the rest of the group still commits; each row
+   written is flagged in job->written. Caller must hold db->rw.mutex.
+   Returns the number of rows written. */
+static int apply_job(mc_db_t *db, db_job_t *job)
+{
+    sqlite3_stmt *fixed = NULL;
+    if (!JOB_KINDS[job->kind].target) {
+        fixed = stmt_get(&db->rw, JOB_KINDS[job->kind].stmt);
+        if (!fixed) return 0;
+    }
+
+    int written = 0;
+    memset(job->written, 0, (size_t)job->count);
+    for (int i = 0; i < job->count; i++) {
+        const void *row = job->rows + (size_t)i * JOB_KINDS[job->kind].row_size;
+        sqlite3_stmt *stmt = fixed ? fixed : JOB_KINDS[job->kind].target(db, row);
+        if (!stmt) continue;
+
+        JOB_KINDS[job->kind].bind(stmt, row);
+        /* The rowid is per connection: clear it so any earlier insert,
+           into whatever table, can't pass for this one */
+        sqlite3_set_last_insert_rowid(db->rw.handle, 0);
+        int rc = sqlite3_step(stmt);
+        if (rc != SQLITE_DONE)
+            MC_LOG_ERROR("Insert %s failed: %s", JOB_KINDS[job->kind].what,
+                         sqlite3_errmsg(db->rw.handle));
+        stmt_release(stmt);
+
+        if (rc == SQLITE_DONE) {
+            written++;
+            job->written[i] = 1;
+            /* An upsert that updated an existing row leaves it at 0 */
+            if (JOB_KINDS[job->kind].count &&
+                sqlite3_last_insert_rowid(db->rw.handle) != 0)
+                JOB_KINDS[job->kind].count(db, row);
+            if (JOB_KINDS[job->kind].after)
+                JOB_KINDS[job->kind].after(db, row);
+        }
+    }
+    return written;
+}
+
+static double elapsed_ms(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) * 1000.0 +
+           (double)(now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+/* Commit a group of jobs in one transaction and free them */
+static void commit_group(mc_db_t *db, db_job_t **jobs, int njobs)
+{
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int rows = 0;
+    pthread_mutex_lock(&db->rw.mutex);
+    if (stmt_exec(&db->rw, STMT_BEGIN) != SQLITE_DONE) {
+        MC_LOG_ERROR("Begin write group: %s", sqlite3_errmsg(db->rw.handle));
+    } else {
+        for (int i = 0; i < njobs; i++)
+            rows += apply_job(db, jobs[i]);
+        uint32_t persisted = strings_flush(db);
+        if (stmt_exec(&db->rw, STMT_COMMIT) != SQLITE_DONE) {
+            MC_LOG_ERROR("Commit write group: %s", sqlite3_errmsg(db->rw.handle));
+            stmt_exec(&db->rw, STMT_ROLLBACK);
+            parts_load(db);
+            rows = 0;
+        } else {
+            db->strings_persisted = persisted;
+        }
+    }
+    counts_commit(db, rows > 0);
+    pthread_mutex_unlock(&db->rw.mutex);
+
+    /* Only entries that were inserted and committed reach the tick log */
+    for (int i = 0; rows > 0 && db->ticks && i < njobs; i++) {
+        if (jobs[i]->kind != JOB_ENTRIES) continue;
+        const mc_data_entry_t *e = (const mc_data_entry_t *)jobs[i]->rows;
+        for (int j = 0; j < jobs[i]->count; j++)
+            if (jobs[i]->written[j])
+                mc_ticks_append(db->ticks, &e[j]);
+    }
+
+    double ms = elapsed_ms(&start);
+    for (int i = 0; i < njobs; i++)
+        free(jobs[i]);
+
+    pthread_mutex_lock(&db->writer_mutex);
+    db->commits++;
+    db->rows_written += (uint64_t)rows;
+    db->last_commit_ms = ms;
+    db->total_commit_ms += ms;
+    if (ms > db->max_commit_ms)
+        db->max_commit_ms = ms;
+    if (rows > 0 && db->commit_hook)
+        db->commit_hook(db->commit_hook_ctx);
+    pthread_mutex_unlock(&db->writer_mutex);
+}
+
+static int queue_push(job_queue_t *q, db_job_t *job)
+{
+    size_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    for (;;) {
+        job_cell_t *cell = &q->cells[pos & (WRITER_QUEUE_CAP - 1)];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + 1,
+                    memory_order_relaxed, memory_order_relaxed)) {
+                cell->job = job;
+                atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+                return 1;
+            }
+        } else if (diff < 0) {
+            return 0; /* Full */
+        } else {
+            pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+        }
+    }
+}
+
+/* Single consumer: only the writer thread (or close, after join) pops */
+static db_job_t *queue_pop(job_queue_t *q)
+{
+    size_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    job_cell_t *cell = &q->cells[pos & (WRITER_QUEUE_CAP - 1)];
+    size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+    if ((intptr_t)seq - (intptr_t)(pos + 1) < 0)
+        return NULL; /* Empty, or the producer has not published yet */
+
+    db_job_t *job = cell->job;
+    atomic_store_explicit(&cell->seq, pos + WRITER_QUEUE_CAP, memory_order_release);
+    atomic_store_explicit(&q->tail, pos + 1, memory_order_relaxed);
+    return job;
+}
+
+static void *writer_thread_func(void *arg)
+{
+    mc_db_t *db = arg;
+    db_job_t *group[WRITER_GROUP_JOBS];
+
+    for (;;) {
+        int njobs = 0, nrows = 0;
+        while (njobs < WRITER_GROUP_JOBS && nrows < WRITER_GROUP_ROWS) {
+            db_job_t *job = queue_pop(&db->queue);
+            if (!job) break;
+            group[njobs++] = job;
+            nrows += job->count;
+        }
+
+        if (njobs > 0) {
+            commit_group(db, group, njobs);
+            continue;
+        }
+
+        /* Queue drained: exit once stopped, otherwise sleep until a push */
+        if (!atomic_load(&db->writer_running))
+            break;
+        sem_wait(&db->writer_wake);
+    }
+    return NULL;
+}
+
+static mc_error_t writer_start(mc_db_t *db)
+{
+    if (db->writer_active) return MC_OK;
+
+    atomic_store(&db->writer_running, 1);
+    if (pthread_create(&db->writer_thread, NULL, writer_thread_func, db) != 0) {
+        atomic_store(&db->writer_running, 0);
+        MC_LOG_ERROR("Failed to start DB writer thread");
+        return MC_ERR_THREAD;
+    }
+    db->writer_active = 1;
+    return MC_OK;
+}
+
+static void writer_stop(mc_db_t *db)
+{
+    if (db->writer_active) {
+        atomic_store(&db->writer_running, 0);
+        sem_post(&db->writer_wake);
+        pthread_join(db->writer_thread, NULL);
+        db->writer_active = 0;
+    }
+
+    /* Anything pushed after the writer exited is committed inline */
+    db_job_t *job;
+    while ((job = queue_pop(&db->queue)) != NULL)
+        commit_group(db, &job, 1);
+}
+
+/* Write a database image next to path and rename it into place, so a
+   crash mid-write leaves the previous checkpoint intact. Journal files
+   belonged to the replaced file and would corrupt the new one.
+   Returns 0, or -errno of the call that failed. */
+static int checkpoint_write(const char *path, const unsigned char *data, size_t size)
+{
+    char tmp[1024];
+    snprintf(tmp, sizeof(tmp), "%s.checkpoint", path);
+
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -errno;
+    int err = 0;
+    size_t off = 0;
+    while (off < size) {
+        ssize_t n = write(fd, data + off, size - off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            err = errno;
+            break;
+        }
+        off += (size_t)n;
+    }
+    if (!err && fsync(fd) != 0) err = errno;
+    close(fd);
+    if (err) {
+        unlink(tmp);
+        return -err;
+    }
+
+    static const char *const suffixes[] = { "-journal", "-wal", "-shm" };
+    for (size_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); i++) {
+        char side[1024];
+        snprintf(side, sizeof(side), "%s%s", path, suffixes[i]);
+        unlink(side);
+    }
+    return rename(tmp, path) == 0 ? 0 : -errno;
+}
+
+static double ms_since(const struct timespec *t0)
+{
+    struct timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (double)(t1.tv_sec - t0->tv_sec) * 1000.0 +
+           (double)(t1.tv_nsec - t0->tv_nsec) / 1e6;
+}
+
+/* Copy the memdb to the on-disk file. Only the in-memory copy runs under
+   a read transaction (commits wait for it); the disk write does not. */
+static void checkpoint_run(mc_db_t *db)
+{
+    struct timespec t0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    sqlite3_int64 size = 0;
+    unsigned char *image = NULL;
+    if (sqlite3_exec(db->checkpoint_src,
+                     "BEGIN; SELECT count(*) FROM sqlite_master;",
+                     NULL, NULL, NULL) == SQLITE_OK)
+        image = sqlite3_serialize(db->checkpoint_src, "main", &size, 0);
+    sqlite3_exec(db->checkpoint_src, "COMMIT;", NULL, NULL, NULL);
+    double copy_ms = ms_since(&t0);
+
+    int rc = image ? checkpoint_write(db->path, image, (size_t)size) : -1;
+    sqlite3_free(image);
+    if (rc != 0)
+        MC_LOG_ERROR("Checkpoint to %s failed: %s", db->path,
+                     image ? strerror(-rc) : sqlite3_errmsg(db->checkpoint_src));
+    double ms = ms_since(&t0);
+
+    pthread_mutex_lock(&db->checkpoint_mutex);
+    if (rc == 0) {
+        db->checkpoints++;
+        db->last_checkpoint_at = time(NULL);
+        db->last_checkpoint_ms = ms;
+        db->last_checkpoint_copy_ms = copy_ms;
+        db->last_checkpoint_bytes = (uint64_t)size;
+    } else {
+        db->checkpoint_failures++;
+    }
+    pthread_mutex_unlock(&db->checkpoint_mutex);
+}
+
+static void *checkpoint_thread_func(void *arg)
+{
+    mc_db_t *db = arg;
+
+    pthread_mutex_lock(&db->checkpoint_mutex);
+    while (!db->checkpoint_quit) {
+        struct timespec ts = { .tv_sec = time(NULL) + db->checkpoint_sec, .tv_nsec = 0 };
+        while (!db->checkpoint_quit &&
+               pthread_cond_timedwait(&db->checkpoint_cond, &db->checkpoint_mutex, &ts) == 0)
+            ;
+        if (db->checkpoint_quit) break;
+
+        pthread_mutex_unlock(&db->checkpoint_mutex);
+        checkpoint_run(db);
+        pthread_mutex_lock(&db->checkpoint_mutex);
+    }
+    pthread_mutex_unlock(&db->checkpoint_mutex);
+    return NULL;
+}
+
+static void checkpoint_start(mc_db_t *db)
+{
+    if (!db->in_memory || db->checkpoint_active) return;
+
+    if (sqlite3_open_v2(db->uri, &db->checkpoint_src,
+                        SQLITE_OPEN_READONLY | SQLITE_OPEN_URI, NULL) != SQLITE_OK) {
+        MC_LOG_ERROR("Checkpoint connection failed: %s",
+                     sqlite3_errmsg(db->checkpoint_src));
+        sqlite3_close(db->checkpoint_src);
+        db->checkpoint_src = NULL;
+        return;
+    }
+    sqlite3_busy_timeout(db->checkpoint_src, 5000);
+
+    db->checkpoint_quit = 0;
+    if (pthread_create(&db->checkpoint_thread, NULL, checkpoint_thread_func, db) != 0) {
+        MC_LOG_ERROR("Failed to start checkpoint thread");
+        return;
+    }
+    db->checkpoint_active = 1;
+}
+
+/* Stop the thread and write a last checkpoint once the writer is idle */
+static void checkpoint_stop(mc_db_t *db)
+{
+    if (db->checkpoint_active) {
+        pthread_mutex_lock(&db->checkpoint_mutex);
+        db->checkpoint_quit = 1;
+        pthread_cond_signal(&db->checkpoint_cond);
+        pthread_mutex_unlock(&db->checkpoint_mutex);
+        pthread_join(db->checkpoint_thread, NULL);
+        db->checkpoint_active = 0;
+    }
+    if (db->checkpoint_src) {
+        checkpoint_run(db);
+        sqlite3_close(db->checkpoint_src);
+        db->checkpoint_src = NULL;
+    }
+}
+
+void mc_db_get_checkpoint_stats(mc_db_t *db, mc_db_checkpoint_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->in_memory = db->in_memory;
+    if (!db->in_memory) return;
+
+    out->interval_sec = db->checkpoint_sec;
+    pthread_mutex_lock(&db->checkpoint_mutex);
+    out->checkpoints = db->checkpoints;
+    out->failures = db->checkpoint_failures;
+    out->last_at = db->last_checkpoint_at;
+    out->last_ms = db->last_checkpoint_ms;
+    out->last_copy_ms = db->last_checkpoint_copy_ms;
+    out->last_bytes = db->last_checkpoint_bytes;
+    pthread_mutex_unlock(&db->checkpoint_mutex);
+}
+
+static void maint_open(mc_db_t *db)
+{
+    if (sqlite3_open_v2(db->uri, &db->maint,
+                        SQLITE_OPEN_READWRITE | SQLITE_OPEN_URI, NULL) != SQLITE_OK) {
+        MC_LOG_WARN("Maintenance connection failed: %s", sqlite3_errmsg(db->maint));
+        sqlite3_close(db->maint);
+        db->maint = NULL;
+        return;
+    }
+    sqlite3_busy_timeout(db->maint, MAINT_BUSY_MS);
+    conn_register_functions(db->maint);
+
+    /* Until the connection has read the file it does not know it is in
+       WAL mode, and checkpoints on it return without doing anything */
+    pragma_int(db->maint, "PRAGMA schema_version");
+}
+
+const char *mc_db_maint_task_str(mc_db_maint_task_t task)
+{
+    switch (task) {
+    case MC_DB_MAINT_CHECKPOINT: return "checkpoint";
+    case MC_DB_MAINT_TRUNCATE:   return "truncate";
+    case MC_DB_MAINT_OPTIMIZE:   return "optimize";
+    case MC_DB_MAINT_VACUUM:     return "vacuum";
+    default:                     return "unknown";
+    }
+}
+
+/* A busy checkpoint is not an error: SQLite copies what it can and the
+   next run continues from there */
+static int maint_checkpoint(mc_db_t *db, int mode)
+{
+    int frames = 0, backfilled = 0;
+    int rc = sqlite3_wal_checkpoint_v2(db->maint, "main", mode, &frames, &backfilled);
+    if (rc == SQLITE_OK || rc == SQLITE_BUSY) {
+        pthread_mutex_lock(&db->maint_mutex);
+        db->wal_frames = frames;
+        db->wal_backfilled = backfilled;
+        pthread_mutex_unlock(&db->maint_mutex);
+    }
+    return rc;
+}
+
+/* Hand back at most MAINT_VACUUM_PAGES free pages per call */
+static int maint_vacuum(mc_db_t *db)
+{
+    int before = pragma_int(db->maint, "PRAGMA freelist_count");
+    if (before <= 0) return before < 0 ? SQLITE_ERROR : SQLITE_OK;
+
+    char sql[64];
+    snprintf(sql, sizeof(sql), "PRAGMA incremental_vacuum(%d);", MAINT_VACUUM_PAGES);
+    int rc = sqlite3_exec(db->maint, sql, NULL, NULL, NULL);
+    int after = pragma_int(db->maint, "PRAGMA freelist_count");
+
+    pthread_mutex_lock(&db->maint_mutex);
+    if (after >= 0) {
+        db->freelist_pages = after;
+        if (after < before) db->pages_vacuumed += (uint64_t)(before - after);
+    }
+    pthread_mutex_unlock(&db->maint_mutex);
+    return rc;
+}
+
+mc_error_t mc_db_maintain(mc_db_t *db, mc_db_maint_task_t task)
+{
+    if (!db->maint || task < 0 || task >= MC_DB_MAINT_COUNT) return MC_ERR_DB;
+
+    /* memdb has no WAL to checkpoint; the checkpoint thread covers it */
+    int wal = task == MC_DB_MAINT_CHECKPOINT || task == MC_DB_MAINT_TRUNCATE;
+    if (wal && db->in_memory) return MC_OK;
+
+    struct timespec t0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int rc;
+    switch (task) {
+    case MC_DB_MAINT_CHECKPOINT:
+        rc = maint_checkpoint(db, SQLITE_CHECKPOINT_PASSIVE);
+        break;
+    case MC_DB_MAINT_TRUNCATE:
+        rc = maint_checkpoint(db, SQLITE_CHECKPOINT_TRUNCATE);
+        break;
+    case MC_DB_MAINT_OPTIMIZE:
+        /* FTS5 keeps pruned rows as delete markers until its segments merge */
+        rc = sqlite3_exec(db->maint,
+            "PRAGMA optimize;"
+            "INSERT INTO news_fts (news_fts) VALUES ('optimize');",
+            NULL, NULL, NULL);
+        break;
+    default:
+        rc = maint_vacuum(db);
+        break;
+    }
+    double ms = ms_since(&t0);
+    if (rc != SQLITE_OK && rc != SQLITE_BUSY)
+        MC_LOG_WARN("DB maintenance %s failed: %s",
+                    mc_db_maint_task_str(task), sqlite3_errmsg(db->maint));
+
+    pthread_mutex_lock(&db->maint_mutex);
+    mc_db_maint_task_stats_t *st = &db->maint_tasks[task];
+    st->runs++;
+    if (rc != SQLITE_OK) st->failures++;
+    st->last_at = time(NULL);
+    st->last_ms = ms;
+    if (ms > st->max_ms) st->max_ms = ms;
+    db->maint_total_ms[task] += ms;
+    pthread_mutex_unlock(&db->maint_mutex);
+
+    return rc == SQLITE_OK ? MC_OK : MC_ERR_DB;
+}
+
+void mc_db_get_maint_stats(mc_db_t *db, mc_db_maint_stats_t *out)
 {
-    if (!db) return;
-    pthread_mutex_lock(&db->mutex);
-    sqlite3_close(db->handle);
-    pthread_mutex_unlock(&db->mutex);
-    pthread_mutex_destroy(&db->mutex);
-    free(db);
+    pthread_mutex_lock(&db->maint_mutex);
+    for (int i = 0; i < MC_DB_MAINT_COUNT; i++) {
+        out->tasks[i] = db->maint_tasks[i];
+        out->tasks[i].avg_ms = db->maint_tasks[i].runs
+            ? db->maint_total_ms[i] / (double)db->maint_tasks[i].runs : 0.0;
+    }
+    out->wal_frames = db->wal_frames;
+    out->wal_backfilled = db->wal_backfilled;
+    out->freelist_pages = db->freelist_pages;
+    out->pages_vacuumed = db->pages_vacuumed;
+    pthread_mutex_unlock(&db->maint_mutex);
 }
 
-mc_error_t mc_db_migrate(mc_db_t *db)
+/* Copy rows into a job and hand it to the writer. Never touches SQLite
+   while the writer runs; before mc_db_migrate() starts it, the job is
+   committed inline so the API stays usable from tools. */
+static mc_error_t enqueue_job(mc_db_t *db, db_job_kind_t kind,
+                              const void *rows, int count)
 {
-    pthread_mutex_lock(&db->mutex);
-    char *err = NULL;
-    int rc = sqlite3_exec(db->handle, SCHEMA_SQL, NULL, NULL, &err);
-    pthread_mutex_unlock(&db->mutex);
+    if (count <= 0) return MC_OK;
+
+    size_t bytes = (size_t)count * JOB_KINDS[kind].row_size;
+    db_job_t *job = malloc(sizeof(*job) + bytes + (size_t)count);
+    if (!job) return MC_ERR_OOM;
+    job->kind = kind;
+    job->count = count;
+    job->written = job->rows + bytes;
+    memcpy(job->rows, rows, bytes);
+
+    if (!atomic_load(&db->writer_running)) {
+        commit_group(db, &job, 1);
+        return MC_OK;
+    }
 
-    if (rc != SQLITE_OK) {
-        MC_LOG_ERROR("Migration failed: %s", err ? err : "unknown");
-        sqlite3_free(err);
+    if (!queue_push(&db->queue, job)) {
+        uint64_t dropped = atomic_fetch_add(&db->dropped, 1) + 1;
+        MC_LOG_WARN("DB writer queue full, dropped %d %s row(s) (%llu jobs dropped)",
+                    count, JOB_KINDS[kind].what, (unsigned long long)dropped);
+        free(job);
         return MC_ERR_DB;
     }
 
-    /* Migration: add base_score column if missing (ignore error = already exists) */
-    err = NULL;
-    sqlite3_exec(db->handle,
-        "ALTER TABLE news_items ADD COLUMN base_score REAL DEFAULT 50.0;",
-        NULL, NULL, &err);
-    if (err) sqlite3_free(err);
+    atomic_fetch_add(&db->enqueued, 1);
+    sem_post(&db->writer_wake);
+    return MC_OK;
+}
 
-    /* Migration: add region/country columns if missing */
-    err = NULL;
-    sqlite3_exec(db->handle,
-        "ALTER TABLE news_items ADD COLUMN region TEXT DEFAULT '';",
-        NULL, NULL, &err);
-    if (err) sqlite3_free(err);
+/* Caller holds ingest_mutex. NULL only if the table cannot grow. */
+static last_quote_t *quote_slot(mc_db_t *db, uint64_t key)
+{
+    if ((db->quote_count + 1) * 2 > db->quote_cap) {
+        uint32_t cap = db->quote_cap ? db->quote_cap * 2 : 1024;
+        last_quote_t *quotes = malloc(cap * sizeof(*quotes));
+        if (!quotes) return NULL;
+        memset(quotes, 0xff, cap * sizeof(*quotes));
+        for (uint32_t i = 0; i < db->quote_cap; i++) {
+            if (db->quotes[i].key == UINT64_MAX) continue;
+            uint32_t h = hash_u64(db->quotes[i].key) & (cap - 1);
+            while (quotes[h].key != UINT64_MAX) h = (h + 1) & (cap - 1);
+            quotes[h] = db->quotes[i];
+        }
+        free(db->quotes);
+        db->quotes = quotes;
+        db->quote_cap = cap;
+    }
 
-    err = NULL;
-    sqlite3_exec(db->handle,
-        "ALTER TABLE news_items ADD COLUMN country TEXT DEFAULT '';",
-        NULL, NULL, &err);
-    if (err) sqlite3_free(err);
+    uint32_t mask = db->quote_cap - 1;
+    uint32_t h = hash_u64(key) & mask;
+    while (db->quotes[h].key != key && db->quotes[h].key != UINT64_MAX)
+        h = (h + 1) & mask;
+    if (db->quotes[h].key == UINT64_MAX) {
+        db->quotes[h].key = key;
+        db->quotes[h].stored_at = 0;
+        db->quote_count++;
+    }
+    return &db->quotes[h];
+}
 
-    MC_LOG_INFO("Database migration complete");
-    return MC_OK;
+/* Caller holds ingest_mutex */
+static ingest_count_t *ingest_counter(mc_db_t *db, uint32_t source_id)
+{
+    for (int i = 0; i < db->ingest_count; i++)
+        if (db->ingest[i].source_id == source_id)
+            return &db->ingest[i];
+    if (db->ingest_count == INGEST_SOURCES_MAX) return NULL;
+    ingest_count_t *c = &db->ingest[db->ingest_count++];
+    c->source_id = source_id;
+    c->received = c->stored = 0;
+    return c;
 }
 
-mc_error_t mc_db_insert_entry(mc_db_t *db, const mc_data_entry_t *e)
+static uint64_t quote_key(const mc_data_entry_t *e)
 {
-    const char *sql =
-        "INSERT INTO data_entries "
-        "(source_name,source_type,category,symbol,display_name,"
-        "value,currency,change_pct,volume,timestamp,fetched_at) "
-        "VALUES (?,?,?,?,?,?,?,?,?,?,?)";
+    return (uint64_t)mc_intern(e->source_name) << 32 | mc_intern(e->symbol);
+}
 
-    pthread_mutex_lock(&db->mutex);
+/* Copy the entries worth storing into out; returns how many */
+static int ingest_filter(mc_db_t *db, const mc_data_entry_t *in, int count,
+                         mc_data_entry_t *out)
+{
+    int kept = 0;
+    pthread_mutex_lock(&db->ingest_mutex);
+    for (int i = 0; i < count; i++) {
+        const mc_data_entry_t *e = &in[i];
+        uint64_t key = quote_key(e);
+        ingest_count_t *c = ingest_counter(db, (uint32_t)(key >> 32));
+        last_quote_t *q = db->tick_heartbeat_sec > 0 ? quote_slot(db, key) : NULL;
+
+        if (q && q->stored_at != 0 &&
+            e->value == q->value && e->change_pct == q->change_pct &&
+            e->volume == q->volume &&
+            e->fetched_at - q->stored_at < db->tick_heartbeat_sec) {
+            db->skipped++;
+            if (c) c->received++;
+            continue;
+        }
+
+        if (q) {
+            q->value = e->value;
+            q->change_pct = e->change_pct;
+            q->volume = e->volume;
+            q->stored_at = e->fetched_at;
+        }
+        if (c) { c->received++; c->stored++; }
+        out[kept++] = *e;
+    }
+    pthread_mutex_unlock(&db->ingest_mutex);
+    return kept;
+}
 
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db->handle, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        pthread_mutex_unlock(&db->mutex);
-        MC_LOG_ERROR("Prepare insert_entry: %s", sqlite3_errmsg(db->handle));
-        return MC_ERR_DB;
+/* The rows never reached the writer: make their next poll store again */
+static void ingest_forget(mc_db_t *db, const mc_data_entry_t *rows, int count)
+{
+    pthread_mutex_lock(&db->ingest_mutex);
+    for (int i = 0; i < count; i++) {
+        ingest_count_t *c = ingest_counter(db, mc_intern(rows[i].source_name));
+        if (c) c->stored--;
+        if (db->tick_heartbeat_sec <= 0) continue;
+        last_quote_t *q = quote_slot(db, quote_key(&rows[i]));
+        if (q) q->stored_at = 0;
     }
+    pthread_mutex_unlock(&db->ingest_mutex);
+}
 
-    sqlite3_bind_text(stmt, 1, e->source_name, -1, SQLITE_STATIC);
-    sqlite3_bind_int(stmt, 2, e->source_type);
-    sqlite3_bind_int(stmt, 3, e->category);
-    sqlite3_bind_text(stmt, 4, e->symbol, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 5, e->display_name, -1, SQLITE_STATIC);
-    sqlite3_bind_double(stmt, 6, e->value);
-    sqlite3_bind_text(stmt, 7, e->currency, -1, SQLITE_STATIC);
-    sqlite3_bind_double(stmt, 8, e->change_pct);
-    sqlite3_bind_double(stmt, 9, e->volume);
-    sqlite3_bind_int64(stmt, 10, e->timestamp);
-    sqlite3_bind_int64(stmt, 11, e->fetched_at);
+void mc_db_set_tick_heartbeat(mc_db_t *db, int heartbeat_sec)
+{
+    pthread_mutex_lock(&db->ingest_mutex);
+    db->tick_heartbeat_sec = heartbeat_sec > 0 ? heartbeat_sec : 0;
+    pthread_mutex_unlock(&db->ingest_mutex);
+}
 
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    pthread_mutex_unlock(&db->mutex);
+mc_error_t mc_db_insert_entries_batch(mc_db_t *db,
+                                      const mc_data_entry_t *entries, int count)
+{
+    if (count <= 0) return MC_OK;
 
-    if (rc != SQLITE_DONE) {
-        MC_LOG_ERROR("Insert entry failed: %s", sqlite3_errmsg(db->handle));
-        return MC_ERR_DB;
-    }
-    return MC_OK;
+    mc_data_entry_t *kept = malloc((size_t)count * sizeof(*kept));
+    if (!kept) return MC_ERR_OOM;
+    int n = ingest_filter(db, entries, count, kept);
+
+    mc_error_t rc = enqueue_job(db, JOB_ENTRIES, kept, n);
+    if (rc != MC_OK)
+        ingest_forget(db, kept, n);
+    free(kept);
+    return rc;
 }
 
-mc_error_t mc_db_insert_news(mc_db_t *db, const mc_news_item_t *item)
+mc_error_t mc_db_insert_news_batch(mc_db_t *db,
+                                   const mc_news_item_t *items, int count)
 {
-    const char *sql =
-        "INSERT INTO news_items "
-        "(title,source,url,summary,category,published_at,fetched_at,base_score,region,country) "
-        "VALUES (?,?,?,?,?,?,?,?,?,?) "
-        "ON CONFLICT(url) DO UPDATE SET region=excluded.region, country=excluded.country "
-        "WHERE excluded.region != '' AND (region IS NULL OR region = '')";
+    return enqueue_job(db, JOB_NEWS, items, count);
+}
 
-    pthread_mutex_lock(&db->mutex);
+mc_error_t mc_db_insert_entry(mc_db_t *db, const mc_data_entry_t *e)
+{
+    return mc_db_insert_entries_batch(db, e, 1);
+}
 
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db->handle, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        pthread_mutex_unlock(&db->mutex);
-        MC_LOG_ERROR("Prepare insert_news: %s", sqlite3_errmsg(db->handle));
-        return MC_ERR_DB;
+mc_error_t mc_db_insert_news(mc_db_t *db, const mc_news_item_t *item)
+{
+    return mc_db_insert_news_batch(db, item, 1);
+}
+
+mc_error_t mc_db_update_source_status(mc_db_t *db, const char *source_name,
+                                      mc_source_type_t type, const char *error)
+{
+    status_row_t st = {0};
+    strncpy(st.source_name, source_name, MC_MAX_SOURCE - 1);
+    st.type = type;
+    st.at = time(NULL);
+    if (error) {
+        st.has_error = 1;
+        strncpy(st.error, error, sizeof(st.error) - 1);
     }
+    return enqueue_job(db, JOB_SOURCE_STATUS, &st, 1);
+}
 
-    sqlite3_bind_text(stmt, 1, item->title, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 2, item->source, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 3, item->url, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 4, item->summary, -1, SQLITE_STATIC);
-    sqlite3_bind_int(stmt, 5, item->category);
-    sqlite3_bind_int64(stmt, 6, item->published_at);
-    sqlite3_bind_int64(stmt, 7, item->fetched_at);
-    sqlite3_bind_double(stmt, 8, item->score);
-    sqlite3_bind_text(stmt, 9, item->region, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 10, item->country, -1, SQLITE_STATIC);
+mc_error_t mc_db_touch_source(mc_db_t *db, const char *source_name, int news)
+{
+    touch_row_t t = {0};
+    strncpy(t.source_name, source_name, MC_MAX_SOURCE - 1);
+    t.at = time(NULL);
+    return enqueue_job(db, news ? JOB_TOUCH_NEWS : JOB_TOUCH_ENTRIES, &t, 1);
+}
 
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    pthread_mutex_unlock(&db->mutex);
+void mc_db_set_commit_hook(mc_db_t *db, mc_db_commit_hook_fn fn, void *ctx)
+{
+    pthread_mutex_lock(&db->writer_mutex);
+    db->commit_hook = fn;
+    db->commit_hook_ctx = ctx;
+    pthread_mutex_unlock(&db->writer_mutex);
+}
 
-    if (rc != SQLITE_DONE) {
-        MC_LOG_ERROR("Insert news failed: %s", sqlite3_errmsg(db->handle));
-        return MC_ERR_DB;
+void mc_db_get_writer_stats(mc_db_t *db, mc_db_writer_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+
+    size_t head = atomic_load(&db->queue.head);
+    size_t tail = atomic_load(&db->queue.tail);
+    out->queue_depth = head > tail ? (int)(head - tail) : 0;
+    out->queue_capacity = WRITER_QUEUE_CAP;
+    out->enqueued = atomic_load(&db->enqueued);
+    out->dropped = atomic_load(&db->dropped);
+
+    pthread_mutex_lock(&db->ingest_mutex);
+    out->skipped = db->skipped;
+    pthread_mutex_unlock(&db->ingest_mutex);
+
+    pthread_mutex_lock(&db->writer_mutex);
+    out->commits = db->commits;
+    out->rows_written = db->rows_written;
+    out->last_commit_ms = db->last_commit_ms;
+    out->avg_commit_ms = db->commits ? db->total_commit_ms / (double)db->commits : 0.0;
+    out->max_commit_ms = db->max_commit_ms;
+    pthread_mutex_unlock(&db->writer_mutex);
+}
+
+int mc_db_get_ingest_stats(mc_db_t *db, mc_db_ingest_stats_t *out, int max_count)
+{
+    pthread_mutex_lock(&db->ingest_mutex);
+    int n = db->ingest_count < max_count ? db->ingest_count : max_count;
+    for (int i = 0; i < n; i++) {
+        memset(&out[i], 0, sizeof(out[i]));
+        strncpy(out[i].source_name, mc_intern_str(db->ingest[i].source_id),
+                MC_MAX_SOURCE - 1);
+        out[i].received = db->ingest[i].received;
+        out[i].stored = db->ingest[i].stored;
     }
-    return MC_OK;
+    pthread_mutex_unlock(&db->ingest_mutex);
+    return n;
 }
 
 static int read_entries(sqlite3_stmt *stmt, mc_data_entry_t *out, int max_count)
@@ -249,32 +2267,83 @@ static int read_entries(sqlite3_stmt *stmt, mc_data_entry_t *out, int max_count)
     return count;
 }
 
-int mc_db_get_latest_entries(mc_db_t *db, mc_category_t cat,
-                             mc_data_entry_t *out, int max_count)
+/* Fill everything but the summary from a news row; the packed summary
+   is returned through z/zlen, valid until the next step */
+static void news_row(sqlite3_stmt *stmt, mc_news_rec_t *r,
+                     const void **z, int *zlen)
 {
-    /* Deduplicate: latest entry per (symbol, source_name)
-       Using ROW_NUMBER() window function — single index scan,
-       no self-join. Requires idx_entries_cat_sym_src_fa. */
-    const char *order = (cat == MC_CAT_STOCK_INDEX || cat == MC_CAT_FOREX
-                         || cat == MC_CAT_COMMODITY)
-        ? "ORDER BY source_name, symbol"
-        : "ORDER BY volume DESC, symbol";
+    memset(r, 0, sizeof(*r));
+    r->id = sqlite3_column_int64(stmt, 0);
 
-    char sql[1024];
-    snprintf(sql, sizeof(sql),
-        "SELECT id,source_name,source_type,category,symbol,"
-        "display_name,value,currency,change_pct,volume,"
-        "timestamp,fetched_at FROM ("
-        "  SELECT *, ROW_NUMBER() OVER ("
-        "    PARTITION BY symbol,source_name ORDER BY fetched_at DESC"
-        "  ) AS rn FROM data_entries WHERE category=?"
-        ") WHERE rn=1 %s LIMIT ?", order);
+    const char *s;
+    s = (const char *)sqlite3_column_text(stmt, 1);
+    if (s) strncpy(r->title, s, MC_MAX_TITLE - 1);
 
-    pthread_mutex_lock(&db->mutex);
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db->handle, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        pthread_mutex_unlock(&db->mutex);
+    s = (const char *)sqlite3_column_text(stmt, 2);
+    if (s) strncpy(r->source, s, MC_MAX_SOURCE - 1);
+
+    s = (const char *)sqlite3_column_text(stmt, 3);
+    if (s) strncpy(r->url, s, MC_MAX_URL - 1);
+
+    *z = sqlite3_column_blob(stmt, 4);
+    *zlen = sqlite3_column_bytes(stmt, 4);
+
+    r->category = sqlite3_column_int(stmt, 5);
+    r->published_at = sqlite3_column_int64(stmt, 6);
+    r->fetched_at = sqlite3_column_int64(stmt, 7);
+    r->score = sqlite3_column_double(stmt, 8);
+
+    s = (const char *)sqlite3_column_text(stmt, 9);
+    if (s) strncpy(r->region, s, MC_MAX_REGION - 1);
+
+    s = (const char *)sqlite3_column_text(stmt, 10);
+    if (s) strncpy(r->country, s, MC_MAX_COUNTRY - 1);
+}
+
+static int read_news(sqlite3_stmt *stmt, mc_news_item_t *out, int max_count)
+{
+    int count = 0;
+    while (count < max_count && sqlite3_step(stmt) == SQLITE_ROW) {
+        mc_news_rec_t r;
+        const void *z;
+        int zlen;
+        news_row(stmt, &r, &z, &zlen);
+        mc_news_rec_unpack(&r, &out[count], 0);
+        mc_summary_unpack(z, (size_t)zlen, out[count].summary, MC_MAX_SUMMARY);
+        count++;
+    }
+    return count;
+}
+
+static int read_news_recs(sqlite3_stmt *stmt, mc_news_rec_t *out, int max_count)
+{
+    int count = 0;
+    while (count < max_count && sqlite3_step(stmt) == SQLITE_ROW) {
+        mc_news_rec_t *r = &out[count];
+        const void *z;
+        int zlen;
+        news_row(stmt, r, &z, &zlen);
+        if (zlen > 0 && (r->summary = malloc((size_t)zlen)) != NULL) {
+            memcpy(r->summary, z, (size_t)zlen);
+            r->summary_len = (uint32_t)zlen;
+        }
+        count++;
+    }
+    return count;
+}
+
+int mc_db_get_latest_entries(mc_db_t *db, mc_category_t cat,
+                             mc_data_entry_t *out, int max_count)
+{
+    stmt_id_t id = (cat == MC_CAT_STOCK_INDEX || cat == MC_CAT_FOREX
+                    || cat == MC_CAT_COMMODITY)
+        ? STMT_LATEST_ENTRIES_BY_NAME
+        : STMT_LATEST_ENTRIES_BY_VOLUME;
+
+    db_conn_t *c = reader_acquire(db);
+    sqlite3_stmt *stmt = stmt_get(c, id);
+    if (!stmt) {
+        reader_release(c);
         return 0;
     }
 
@@ -282,138 +2351,133 @@ int mc_db_get_latest_entries(mc_db_t *db, mc_category_t cat,
     sqlite3_bind_int(stmt, 2, max_count);
 
     int count = read_entries(stmt, out, max_count);
-    sqlite3_finalize(stmt);
-    pthread_mutex_unlock(&db->mutex);
+    stmt_release(stmt);
+    reader_release(c);
     return count;
 }
 
 int mc_db_get_latest_news(mc_db_t *db, mc_category_t cat,
                           mc_news_item_t *out, int max_count)
 {
-    const char *sql =
-        "SELECT id,title,source,url,summary,category,published_at,fetched_at,base_score,region,country "
-        "FROM news_items WHERE category=? "
-        "ORDER BY base_score DESC, published_at DESC LIMIT ?";
-
-    pthread_mutex_lock(&db->mutex);
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db->handle, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        pthread_mutex_unlock(&db->mutex);
+    db_conn_t *c = reader_acquire(db);
+    sqlite3_stmt *stmt = stmt_get(c, STMT_LATEST_NEWS);
+    if (!stmt) {
+        reader_release(c);
         return 0;
     }
 
     sqlite3_bind_int(stmt, 1, cat);
     sqlite3_bind_int(stmt, 2, max_count);
 
-    int count = 0;
-    while (count < max_count && sqlite3_step(stmt) == SQLITE_ROW) {
-        mc_news_item_t *n = &out[count];
-        memset(n, 0, sizeof(*n));
-
-        n->id = sqlite3_column_int64(stmt, 0);
-
-        const char *s;
-        s = (const char *)sqlite3_column_text(stmt, 1);
-        if (s) strncpy(n->title, s, MC_MAX_TITLE - 1);
-
-        s = (const char *)sqlite3_column_text(stmt, 2);
-        if (s) strncpy(n->source, s, MC_MAX_SOURCE - 1);
-
-        s = (const char *)sqlite3_column_text(stmt, 3);
-        if (s) strncpy(n->url, s, MC_MAX_URL - 1);
-
-        s = (const char *)sqlite3_column_text(stmt, 4);
-        if (s) strncpy(n->summary, s, MC_MAX_SUMMARY - 1);
-
-        n->category = sqlite3_column_int(stmt, 5);
-        n->published_at = sqlite3_column_int64(stmt, 6);
-        n->fetched_at = sqlite3_column_int64(stmt, 7);
-        n->score = sqlite3_column_double(stmt, 8);
-
-        s = (const char *)sqlite3_column_text(stmt, 9);
-        if (s) strncpy(n->region, s, MC_MAX_REGION - 1);
-
-        s = (const char *)sqlite3_column_text(stmt, 10);
-        if (s) strncpy(n->country, s, MC_MAX_COUNTRY - 1);
-
-        count++;
-    }
-    sqlite3_finalize(stmt);
-    pthread_mutex_unlock(&db->mutex);
+    int count = read_news(stmt, out, max_count);
+    stmt_release(stmt);
+    reader_release(c);
     return count;
 }
 
 int mc_db_get_all_latest_news(mc_db_t *db,
                                mc_news_item_t *out, int max_count)
 {
-    const char *sql =
-        "SELECT id,title,source,url,summary,category,published_at,fetched_at,base_score,region,country "
-        "FROM news_items "
-        "ORDER BY base_score DESC, published_at DESC LIMIT ?";
-
-    pthread_mutex_lock(&db->mutex);
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db->handle, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        pthread_mutex_unlock(&db->mutex);
+    db_conn_t *c = reader_acquire(db);
+    sqlite3_stmt *stmt = stmt_get(c, STMT_ALL_LATEST_NEWS);
+    if (!stmt) {
+        reader_release(c);
         return 0;
     }
 
     sqlite3_bind_int(stmt, 1, max_count);
 
-    int count = 0;
-    while (count < max_count && sqlite3_step(stmt) == SQLITE_ROW) {
-        mc_news_item_t *n = &out[count];
-        memset(n, 0, sizeof(*n));
-
-        n->id = sqlite3_column_int64(stmt, 0);
+    int count = read_news(stmt, out, max_count);
+    stmt_release(stmt);
+    reader_release(c);
+    return count;
+}
 
-        const char *s;
-        s = (const char *)sqlite3_column_text(stmt, 1);
-        if (s) strncpy(n->title, s, MC_MAX_TITLE - 1);
+int mc_db_get_all_latest_news_recs(mc_db_t *db,
+                                   mc_news_rec_t *out, int max_count)
+{
+    db_conn_t *c = reader_acquire(db);
+    sqlite3_stmt *stmt = stmt_get(c, STMT_ALL_LATEST_NEWS);
+    if (!stmt) {
+        reader_release(c);
+        return 0;
+    }
 
-        s = (const char *)sqlite3_column_text(stmt, 2);
-        if (s) strncpy(n->source, s, MC_MAX_SOURCE - 1);
+    sqlite3_bind_int(stmt, 1, max_count);
 
-        s = (const char *)sqlite3_column_text(stmt, 3);
-        if (s) strncpy(n->url, s, MC_MAX_URL - 1);
+    int count = read_news_recs(stmt, out, max_count);
+    stmt_release(stmt);
+    reader_release(c);
+    return count;
+}
 
-        s = (const char *)sqlite3_column_text(stmt, 4);
-        if (s) strncpy(n->summary, s, MC_MAX_SUMMARY - 1);
+/* Turn free text into an FTS5 query: every word becomes a quoted term
+   (implicit AND), so punctuation and operators in user input cannot
+   break the syntax. A trailing '*' keeps prefix search. Returns 0 if
+   there are no words. */
+static int fts_query(const char *q, char *out, size_t size)
+{
+    size_t o = 0;
+    int terms = 0;
+
+    while (*q) {
+        while (*q == ' ' || *q == '\t') q++;
+        if (!*q) break;
+
+        const char *w = q;
+        while (*q && *q != ' ' && *q != '\t') q++;
+        size_t len = (size_t)(q - w);
+        int prefix = len > 1 && w[len - 1] == '*';
+        if (prefix) len--;
+
+        /* Worst case every char is a doubled quote, plus quotes, '*', space */
+        if (o + len * 2 + 5 >= size) break;
+        if (terms++) out[o++] = ' ';
+        out[o++] = '"';
+        for (size_t i = 0; i < len; i++) {
+            if (w[i] == '"') out[o++] = '"';
+            out[o++] = w[i];
+        }
+        out[o++] = '"';
+        if (prefix) out[o++] = '*';
+    }
+    out[o] = '\0';
+    return terms;
+}
 
-        n->category = sqlite3_column_int(stmt, 5);
-        n->published_at = sqlite3_column_int64(stmt, 6);
-        n->fetched_at = sqlite3_column_int64(stmt, 7);
-        n->score = sqlite3_column_double(stmt, 8);
+int mc_db_search_news(mc_db_t *db, const char *query,
+                      mc_news_item_t *out, int max_count)
+{
+    char match[1024];
+    if (!query || !fts_query(query, match, sizeof(match)))
+        return 0;
 
-        s = (const char *)sqlite3_column_text(stmt, 9);
-        if (s) strncpy(n->region, s, MC_MAX_REGION - 1);
+    db_conn_t *c = reader_acquire(db);
+    sqlite3_stmt *stmt = stmt_get(c, STMT_SEARCH_NEWS);
+    if (!stmt) {
+        reader_release(c);
+        return 0;
+    }
 
-        s = (const char *)sqlite3_column_text(stmt, 10);
-        if (s) strncpy(n->country, s, MC_MAX_COUNTRY - 1);
+    sqlite3_bind_text(stmt, 1, match, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, max_count);
 
-        count++;
-    }
-    sqlite3_finalize(stmt);
-    pthread_mutex_unlock(&db->mutex);
+    int count = read_news(stmt, out, max_count);
+    stmt_release(stmt);
+    reader_release(c);
     return count;
 }
 
 int mc_db_get_entry_history(mc_db_t *db, const char *symbol,
                             mc_data_entry_t *out, int max_count)
 {
-    const char *sql =
-        "SELECT id,source_name,source_type,category,symbol,display_name,"
-        "value,currency,change_pct,volume,timestamp,fetched_at "
-        "FROM data_entries WHERE symbol=? "
-        "ORDER BY timestamp DESC LIMIT ?";
+    if (db->ticks)
+        return mc_ticks_history(db->ticks, symbol, out, max_count);
 
-    pthread_mutex_lock(&db->mutex);
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db->handle, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        pthread_mutex_unlock(&db->mutex);
+    db_conn_t *c = reader_acquire(db);
+    sqlite3_stmt *stmt = stmt_get(c, STMT_ENTRY_HISTORY);
+    if (!stmt) {
+        reader_release(c);
         return 0;
     }
 
@@ -421,112 +2485,199 @@ int mc_db_get_entry_history(mc_db_t *db, const char *symbol,
     sqlite3_bind_int(stmt, 2, max_count);
 
     int count = read_entries(stmt, out, max_count);
-    sqlite3_finalize(stmt);
-    pthread_mutex_unlock(&db->mutex);
+    stmt_release(stmt);
+    reader_release(c);
     return count;
 }
 
-mc_error_t mc_db_update_source_status(mc_db_t *db, const char *source_name,
-                                      mc_source_type_t type, const char *error)
+int mc_db_candle_res_parse(const char *s)
 {
-    const char *sql =
-        "INSERT INTO source_status (source_name,source_type,last_fetched,last_error,error_count) "
-        "VALUES (?,?,?,?,?) "
-        "ON CONFLICT(source_name) DO UPDATE SET "
-        "last_fetched=excluded.last_fetched,"
-        "last_error=excluded.last_error,"
-        "error_count=CASE WHEN excluded.last_error IS NULL THEN 0 "
-        "ELSE source_status.error_count+1 END";
+    for (int i = 0; s && i < CANDLE_RES_COUNT; i++)
+        if (strcmp(s, CANDLE_RES[i].name) == 0)
+            return CANDLE_RES[i].sec;
+    return 0;
+}
 
-    pthread_mutex_lock(&db->mutex);
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db->handle, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        pthread_mutex_unlock(&db->mutex);
-        return MC_ERR_DB;
+int mc_db_get_candles(mc_db_t *db, const char *symbol, int res_sec,
+                      const char *source, time_t from, time_t to,
+                      mc_candle_t *out, int max_count)
+{
+    db_conn_t *c = reader_acquire(db);
+    sqlite3_stmt *stmt = stmt_get(c, STMT_CANDLES);
+    if (!stmt) {
+        reader_release(c);
+        return 0;
     }
 
-    sqlite3_bind_text(stmt, 1, source_name, -1, SQLITE_STATIC);
-    sqlite3_bind_int(stmt, 2, type);
-    sqlite3_bind_int64(stmt, 3, time(NULL));
-    if (error)
-        sqlite3_bind_text(stmt, 4, error, -1, SQLITE_STATIC);
-    else
-        sqlite3_bind_null(stmt, 4);
-    sqlite3_bind_int(stmt, 5, error ? 1 : 0);
+    sqlite3_bind_text(stmt, 1, symbol, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, res_sec);
+    sqlite3_bind_int64(stmt, 3, from);
+    sqlite3_bind_int64(stmt, 4, to);
+    if (source)
+        sqlite3_bind_text(stmt, 5, source, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 6, max_count);
 
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    pthread_mutex_unlock(&db->mutex);
+    int count = 0;
+    while (count < max_count && sqlite3_step(stmt) == SQLITE_ROW) {
+        mc_candle_t *k = &out[count];
+        memset(k, 0, sizeof(*k));
+
+        const char *s = (const char *)sqlite3_column_text(stmt, 0);
+        if (s) strncpy(k->source_name, s, MC_MAX_SOURCE - 1);
+
+        k->bucket = sqlite3_column_int64(stmt, 1);
+        k->open = sqlite3_column_double(stmt, 2);
+        k->high = sqlite3_column_double(stmt, 3);
+        k->low = sqlite3_column_double(stmt, 4);
+        k->close = sqlite3_column_double(stmt, 5);
+        k->volume = sqlite3_column_double(stmt, 6);
+        k->ticks = sqlite3_column_int(stmt, 7);
+        count++;
+    }
+    stmt_release(stmt);
+    reader_release(c);
+
+    /* Fetched newest first; return in chart order */
+    for (int i = 0, j = count - 1; i < j; i++, j--) {
+        mc_candle_t tmp = out[i];
+        out[i] = out[j];
+        out[j] = tmp;
+    }
+    return count;
+}
 
-    return (rc == SQLITE_DONE) ? MC_OK : MC_ERR_DB;
+/* Entry retention: drop the partitions lying wholly before the cutoff,
+   always keeping the newest so the view stays defined. Cost depends on
+   the number of partitions, not rows. Caller must hold db->rw.mutex. */
+static int drop_partitions(mc_db_t *db, time_t cutoff)
+{
+    int n = 0;
+    while (n < db->part_count - 1 && db->parts[n] + ENTRY_PARTITION_SEC <= cutoff)
+        n++;
+    if (n == 0) return SQLITE_DONE;
+
+    int rc = stmt_exec(&db->rw, STMT_BEGIN);
+    for (int i = 0; rc == SQLITE_DONE && i < n; i++) {
+        char name[64], sql[160];
+        part_name(db->parts[i], name, sizeof(name));
+        snprintf(sql, sizeof(sql),
+                 "SELECT source_id,category,count(*) FROM %s GROUP BY 1,2", name);
+        if (tally_query(db->rw.handle, sql, &db->pending_entries, -1) != SQLITE_OK) {
+            rc = SQLITE_ERROR;
+            break;
+        }
+        snprintf(sql, sizeof(sql), "DROP TABLE %s;", name);
+        if (db->part_insert && db->part_insert_start == db->parts[i]) {
+            sqlite3_finalize(db->part_insert);
+            db->part_insert = NULL;
+        }
+        if (sqlite3_exec(db->rw.handle, sql, NULL, NULL, NULL) != SQLITE_OK)
+            rc = SQLITE_ERROR;
+    }
+
+    if (rc == SQLITE_DONE) {
+        db->part_count -= n;
+        memmove(db->parts, db->parts + n, (size_t)db->part_count * sizeof(db->parts[0]));
+        if (view_rebuild(db) != SQLITE_OK || stmt_exec(&db->rw, STMT_COMMIT) != SQLITE_DONE)
+            rc = SQLITE_ERROR;
+    }
+
+    if (rc != SQLITE_DONE) {
+        MC_LOG_ERROR("Drop entry partitions: %s", sqlite3_errmsg(db->rw.handle));
+        stmt_exec(&db->rw, STMT_ROLLBACK);
+        parts_load(db);
+    }
+    counts_commit(db, rc == SQLITE_DONE);
+    return rc;
 }
 
 mc_error_t mc_db_prune_old(mc_db_t *db, int max_age_sec)
 {
     time_t cutoff = time(NULL) - max_age_sec;
+    static const stmt_id_t prune_stmts[] = {
+        STMT_PRUNE_LATEST_ENTRIES, STMT_PRUNE_NEWS
+    };
+
+    pthread_mutex_lock(&db->rw.mutex);
+    int rc = drop_partitions(db, cutoff);
+    for (size_t i = 0; rc == SQLITE_DONE && i < sizeof(prune_stmts) / sizeof(prune_stmts[0]); i++) {
+        sqlite3_stmt *stmt = stmt_get(&db->rw, prune_stmts[i]);
+        if (!stmt) { rc = SQLITE_ERROR; break; }
+
+        sqlite3_bind_int64(stmt, 1, cutoff);
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+            tally_add(&db->pending_news,
+                      tally_key(mc_intern((const char *)sqlite3_column_text(stmt, 0)),
+                                sqlite3_column_int(stmt, 1)), -1);
+        if (rc != SQLITE_DONE)
+            MC_LOG_ERROR("Prune failed: %s", sqlite3_errmsg(db->rw.handle));
+        stmt_release(stmt);
+        counts_commit(db, rc == SQLITE_DONE);
+        if (rc != SQLITE_DONE) break;
+    }
 
-    pthread_mutex_lock(&db->mutex);
-    char *err = NULL;
-    char sql[256];
-
-    snprintf(sql, sizeof(sql),
-             "DELETE FROM data_entries WHERE fetched_at < %ld;"
-             "DELETE FROM news_items WHERE fetched_at < %ld;",
-             (long)cutoff, (long)cutoff);
+    /* Candles outlive raw history, each resolution on its own horizon */
+    time_t now = cutoff + max_age_sec;
+    for (int i = 0; rc == SQLITE_DONE && i < CANDLE_RES_COUNT; i++) {
+        if (CANDLE_RES[i].keep_sec == 0) continue;
+        sqlite3_stmt *stmt = stmt_get(&db->rw, STMT_PRUNE_CANDLES);
+        if (!stmt) { rc = SQLITE_ERROR; break; }
+
+        sqlite3_bind_int(stmt, 1, CANDLE_RES[i].sec);
+        sqlite3_bind_int64(stmt, 2, now - CANDLE_RES[i].keep_sec);
+        rc = sqlite3_step(stmt);
+        if (rc != SQLITE_DONE)
+            MC_LOG_ERROR("Prune candles failed: %s", sqlite3_errmsg(db->rw.handle));
+        stmt_release(stmt);
+    }
+    pthread_mutex_unlock(&db->rw.mutex);
 
-    int rc = sqlite3_exec(db->handle, sql, NULL, NULL, &err);
-    pthread_mutex_unlock(&db->mutex);
+    if (db->ticks)
+        mc_ticks_prune(db->ticks, cutoff);
 
-    if (rc != SQLITE_OK) {
-        MC_LOG_ERROR("Prune failed: %s", err ? err : "unknown");
-        sqlite3_free(err);
-        return MC_ERR_DB;
-    }
-    return MC_OK;
+    return (rc == SQLITE_DONE) ? MC_OK : MC_ERR_DB;
 }
 
 int mc_db_count_entries(mc_db_t *db)
 {
-    pthread_mutex_lock(&db->mutex);
-    sqlite3_stmt *stmt;
-    int count = 0;
-    if (sqlite3_prepare_v2(db->handle,
-            "SELECT COUNT(*) FROM data_entries", -1, &stmt, NULL) == SQLITE_OK) {
-        if (sqlite3_step(stmt) == SQLITE_ROW)
-            count = sqlite3_column_int(stmt, 0);
-        sqlite3_finalize(stmt);
-    }
-    pthread_mutex_unlock(&db->mutex);
-    return count;
+    pthread_mutex_lock(&db->counts_mutex);
+    int64_t n = db->entry_counts.total;
+    pthread_mutex_unlock(&db->counts_mutex);
+    return (int)n;
 }
 
 int mc_db_count_news(mc_db_t *db)
 {
-    pthread_mutex_lock(&db->mutex);
-    sqlite3_stmt *stmt;
+    pthread_mutex_lock(&db->counts_mutex);
+    int64_t n = db->news_counts.total;
+    pthread_mutex_unlock(&db->counts_mutex);
+    return (int)n;
+}
+
+int mc_db_get_row_counts(mc_db_t *db, int news, mc_db_row_count_t *out, int max_count)
+{
     int count = 0;
-    if (sqlite3_prepare_v2(db->handle,
-            "SELECT COUNT(*) FROM news_items", -1, &stmt, NULL) == SQLITE_OK) {
-        if (sqlite3_step(stmt) == SQLITE_ROW)
-            count = sqlite3_column_int(stmt, 0);
-        sqlite3_finalize(stmt);
+    pthread_mutex_lock(&db->counts_mutex);
+    const tally_t *t = news ? &db->news_counts : &db->entry_counts;
+    for (uint32_t i = 0; i < t->cap && count < max_count; i++) {
+        const tally_slot_t *slot = &t->slots[i];
+        if (slot->key == UINT64_MAX || slot->rows == 0) continue;
+        mc_db_row_count_t *rc = &out[count++];
+        snprintf(rc->source_name, sizeof(rc->source_name), "%s",
+                 mc_intern_str((uint32_t)(slot->key >> 8)));
+        rc->category = (mc_category_t)(slot->key & 0xff);
+        rc->rows = slot->rows;
     }
-    pthread_mutex_unlock(&db->mutex);
+    pthread_mutex_unlock(&db->counts_mutex);
     return count;
 }
 
 int mc_db_get_source_statuses(mc_db_t *db, mc_source_status_t *out, int max_count)
 {
-    const char *sql =
-        "SELECT source_name,source_type,last_fetched,last_error,error_count "
-        "FROM source_status ORDER BY source_name";
-
-    pthread_mutex_lock(&db->mutex);
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db->handle, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        pthread_mutex_unlock(&db->mutex);
+    db_conn_t *c = reader_acquire(db);
+    sqlite3_stmt *stmt = stmt_get(c, STMT_SOURCE_STATUSES);
+    if (!stmt) {
+        reader_release(c);
         return 0;
     }
 
@@ -548,7 +2699,7 @@ int mc_db_get_source_statuses(mc_db_t *db, mc_source_status_t *out, int max_coun
         count++;
     }
 
-    sqlite3_finalize(stmt);
-    pthread_mutex_unlock(&db->mutex);
+    stmt_release(stmt);
+    reader_release(c);
     return count;
 }
@@ -2,8 +2,8 @@
 #include "mc_fetch_rest.h"
 #include "mc_log.h"
 
-#include <curl/curl.h>
 #include <cJSON.h>
+#include <stdio.h>
 #include <string.h>
 #include <strings.h>
 #include <stdlib.h>
@@ -209,24 +209,6 @@ static const char *lookup_commodity_name(const char *symbol)
     return NULL;
 }
 
-typedef struct {
-    char  *data;
-    size_t size;
-} mem_buf_t;
-
-static size_t write_cb(void *ptr, size_t size, size_t nmemb, void *userdata)
-{
-    mem_buf_t *buf = userdata;
-    size_t total = size * nmemb;
-    char *tmp = realloc(buf->data, buf->size + total + 1);
-    if (!tmp) return 0;
-    buf->data = tmp;
-    memcpy(buf->data + buf->size, ptr, total);
-    buf->size += total;
-    buf->data[buf->size] = '\0';
-    return total;
-}
-
 static void parse_binance_ticker(cJSON *item, mc_data_entry_t *e,
                                   const char *source_name)
 {
@@ -681,118 +663,62 @@ static int parse_calendar_events(const char *json,
     return count;
 }
 
-int mc_fetch_rest_calendar(const mc_rest_source_cfg_t *cfg,
-                           mc_news_item_t *news_out, int max_items)
-{
-    MC_LOG_DEBUG("Fetching calendar: %s", cfg->name);
-
-    char url[1024];
-    if (cfg->params[0])
-        snprintf(url, sizeof(url), "%s%s?%s", cfg->base_url, cfg->endpoint, cfg->params);
-    else
-        snprintf(url, sizeof(url), "%s%s", cfg->base_url, cfg->endpoint);
-
-    CURL *curl = curl_easy_init();
-    if (!curl) return -1;
-
-    mem_buf_t buf = {0};
-    curl_easy_setopt(curl, CURLOPT_URL, url);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_cb);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &buf);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 15L);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "Poulailler/0.1");
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_easy_cleanup(curl);
-
-    if (res != CURLE_OK) {
-        MC_LOG_ERROR("Calendar fetch failed for %s: %s", cfg->name,
-                     curl_easy_strerror(res));
-        free(buf.data);
-        return -1;
-    }
-
-    int count = parse_calendar_events(buf.data, cfg, news_out, max_items);
-    free(buf.data);
-
-    MC_LOG_INFO("Calendar %s: got %d events", cfg->name, count);
-    return count;
-}
-
-int mc_fetch_rest(const mc_rest_source_cfg_t *cfg,
-                  mc_data_entry_t *entries_out, int max_entries)
+void mc_fetch_rest_request(const mc_rest_source_cfg_t *cfg, mc_http_request_t *req)
 {
-    MC_LOG_DEBUG("Fetching REST: %s", cfg->name);
-
-    /* Build URL */
-    char url[1024];
+    memset(req, 0, sizeof(*req));
     if (cfg->params[0])
-        snprintf(url, sizeof(url), "%s%s?%s", cfg->base_url, cfg->endpoint, cfg->params);
+        snprintf(req->url, sizeof(req->url), "%s%s?%s",
+                 cfg->base_url, cfg->endpoint, cfg->params);
     else
-        snprintf(url, sizeof(url), "%s%s", cfg->base_url, cfg->endpoint);
-
-    CURL *curl = curl_easy_init();
-    if (!curl) return -1;
-
-    mem_buf_t buf = {0};
-    struct curl_slist *headers = NULL;
+        snprintf(req->url, sizeof(req->url), "%s%s", cfg->base_url, cfg->endpoint);
+    req->timeout_sec = 15;
+    req->identity_encoding = !cfg->compression;
+    /* The calendar feed has always been fetched under this name */
+    if (cfg->category == MC_CAT_FINANCIAL_NEWS)
+        req->user_agent = "Poulailler/0.1";
 
     /* Set API key header if configured */
     if (cfg->api_key_header[0] && cfg->api_key[0]) {
         char hdr[256];
         snprintf(hdr, sizeof(hdr), "%s: %s", cfg->api_key_header, cfg->api_key);
-        headers = curl_slist_append(headers, hdr);
+        mc_http_add_header(req, hdr);
     }
 
-    curl_easy_setopt(curl, CURLOPT_URL, url);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_cb);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &buf);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 15L);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "MonitorCrebirth/0.1");
-
     /* Apply HTTP method from config */
     if (strcasecmp(cfg->method, "POST") == 0) {
-        curl_easy_setopt(curl, CURLOPT_POST, 1L);
-        if (cfg->post_body[0]) {
-            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, cfg->post_body);
-            headers = curl_slist_append(headers, "Content-Type: application/json");
-        } else {
-            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, "");
-        }
+        req->post_body = cfg->post_body;
+        if (cfg->post_body[0])
+            mc_http_add_header(req, "Content-Type: application/json");
     }
+}
 
-    if (headers)
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_easy_cleanup(curl);
-    if (headers) curl_slist_free_all(headers);
-
-    if (res != CURLE_OK) {
-        MC_LOG_ERROR("REST fetch failed for %s: %s", cfg->name,
-                     curl_easy_strerror(res));
-        free(buf.data);
-        return -1;
-    }
+int mc_fetch_rest_calendar_parse(const mc_rest_source_cfg_t *cfg, const char *body,
+                                 mc_news_item_t *news_out, int max_items)
+{
+    int count = parse_calendar_events(body, cfg, news_out, max_items);
+    MC_LOG_INFO("Calendar %s: got %d events", cfg->name, count);
+    return count;
+}
 
+int mc_fetch_rest_parse(const mc_rest_source_cfg_t *cfg, const char *body,
+                        mc_data_entry_t *entries_out, int max_entries)
+{
     /* Route to the correct parser */
     int count = 0;
 
     if (cfg->field_price[0]) {
         /* Generic parser: use field mappings from config */
-        count = parse_generic_response(buf.data, cfg, entries_out, max_entries);
+        count = parse_generic_response(body, cfg, entries_out, max_entries);
     } else if (strstr(cfg->name, "Binance") || strstr(cfg->name, "binance")) {
-        count = parse_binance_response(buf.data, cfg->name, cfg, entries_out, max_entries);
+        count = parse_binance_response(body, cfg->name, cfg, entries_out, max_entries);
     } else if ((strstr(cfg->name, "CoinGecko") || strstr(cfg->name, "coingecko"))
                && strcmp(cfg->response_format, "json_object") == 0) {
-        count = parse_coingecko_response(buf.data, cfg->name, entries_out, max_entries);
+        count = parse_coingecko_response(body, cfg->name, entries_out, max_entries);
     } else {
         /* Fallback: try generic with common field names */
-        count = parse_generic_response(buf.data, cfg, entries_out, max_entries);
+        count = parse_generic_response(body, cfg, entries_out, max_entries);
     }
 
-    free(buf.data);
-
     /* Post-process: fill display_name from lookup table for known symbols */
     if (cfg->category == MC_CAT_STOCK_INDEX) {
         for (int i = 0; i < count; i++) {
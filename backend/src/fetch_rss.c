@@ -2,31 +2,13 @@
 #include "mc_fetch_rss.h"
 #include "mc_log.h"
 
-#include <curl/curl.h>
 #include <libxml/parser.h>
 #include <libxml/xpath.h>
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
 
-typedef struct {
-    char  *data;
-    size_t size;
-} mem_buf_t;
-
-static size_t write_cb(void *ptr, size_t size, size_t nmemb, void *userdata)
-{
-    mem_buf_t *buf = userdata;
-    size_t total = size * nmemb;
-    char *tmp = realloc(buf->data, buf->size + total + 1);
-    if (!tmp) return 0;
-    buf->data = tmp;
-    memcpy(buf->data + buf->size, ptr, total);
-    buf->size += total;
-    buf->data[buf->size] = '\0';
-    return total;
-}
-
 static void strip_html(char *dst, const char *src, size_t max)
 {
     size_t j = 0;
@@ -144,36 +126,19 @@ static int parse_feed(const char *xml_data, size_t xml_len,
     return count;
 }
 
-int mc_fetch_rss(const mc_rss_source_cfg_t *cfg,
-                 mc_news_item_t *items_out, int max_items)
+void mc_fetch_rss_request(const mc_rss_source_cfg_t *cfg, mc_http_request_t *req)
 {
-    MC_LOG_DEBUG("Fetching RSS: %s (%s)", cfg->name, cfg->url);
-
-    CURL *curl = curl_easy_init();
-    if (!curl) return -1;
-
-    mem_buf_t buf = {0};
-
-    curl_easy_setopt(curl, CURLOPT_URL, cfg->url);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_cb);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &buf);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 15L);
-    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "MonitorCrebirth/0.1");
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_easy_cleanup(curl);
-
-    if (res != CURLE_OK) {
-        MC_LOG_ERROR("RSS fetch failed for %s: %s", cfg->name,
-                     curl_easy_strerror(res));
-        free(buf.data);
-        return -1;
-    }
-
-    int count = parse_feed(buf.data, buf.size, cfg, items_out, max_items);
-    free(buf.data);
+    memset(req, 0, sizeof(*req));
+    snprintf(req->url, sizeof(req->url), "%s", cfg->url);
+    req->timeout_sec = 15;
+    req->follow_location = 1;
+    req->identity_encoding = !cfg->compression;
+}
 
+int mc_fetch_rss_parse(const mc_rss_source_cfg_t *cfg, const char *body, size_t size,
+                       mc_news_item_t *items_out, int max_items)
+{
+    int count = parse_feed(body, size, cfg, items_out, max_items);
     MC_LOG_INFO("RSS %s: got %d items", cfg->name, count);
     return count;
 }
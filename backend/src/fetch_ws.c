@@ -10,6 +10,9 @@
 #include <time.h>
 #include <unistd.h>
 
+#define WS_BATCH_MAX       64  /* Flush buffered ticks at this many rows */
+#define WS_FLUSH_INTERVAL  1   /* ...or when the oldest is this many seconds old */
+
 struct mc_ws_conn {
     mc_ws_source_cfg_t  cfg;
     mc_db_t            *db;
@@ -19,8 +22,24 @@ struct mc_ws_conn {
     volatile int        running;
     volatile int        connected;
     struct lws_context *lws_ctx;
+
+    /* Ticks buffered between DB flushes (touched only by the WS thread) */
+    mc_data_entry_t     pending[WS_BATCH_MAX];
+    int                 pending_count;
+    time_t              pending_since;
 };
 
+static void flush_pending(mc_ws_conn_t *conn)
+{
+    if (conn->pending_count == 0) return;
+
+    mc_db_insert_entries_batch(conn->db, conn->pending, conn->pending_count);
+    conn->pending_count = 0;
+
+    if (conn->on_data)
+        conn->on_data(conn->on_data_ctx);
+}
+
 static int ws_callback(struct lws *wsi, enum lws_callback_reasons reason,
                        void *user, void *in, size_t len)
 {
@@ -86,9 +105,11 @@ static int ws_callback(struct lws *wsi, enum lws_callback_reasons reason,
         entry.fetched_at = time(NULL);
 
         if (entry.symbol[0] && entry.value > 0) {
-            mc_db_insert_entry(conn->db, &entry);
-            if (conn->on_data)
-                conn->on_data(conn->on_data_ctx);
+            if (conn->pending_count == 0)
+                conn->pending_since = entry.fetched_at;
+            conn->pending[conn->pending_count++] = entry;
+            if (conn->pending_count == WS_BATCH_MAX)
+                flush_pending(conn);
         }
 
         cJSON_Delete(root);
@@ -196,6 +217,10 @@ static void *ws_thread_func(void *arg)
             int n = lws_service(conn->lws_ctx, 250);
             if (n < 0) break;
 
+            if (conn->pending_count > 0 &&
+                time(NULL) - conn->pending_since >= WS_FLUSH_INTERVAL)
+                flush_pending(conn);
+
             if (conn->connected) {
                 was_connected = 1;
             } else if (was_connected) {
@@ -214,6 +239,7 @@ static void *ws_thread_func(void *arg)
         lws_context_destroy(conn->lws_ctx);
         conn->lws_ctx = NULL;
         conn->connected = 0;
+        flush_pending(conn);
 
         if (conn->running) {
             MC_LOG_INFO("WS reconnecting %s in %ds", conn->cfg.name,
@@ -0,0 +1,751 @@
+#include "mc_http.h"
+#include "mc_log.h"
+
+#include <curl/curl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#define HTTP_EPOLL_BATCH  64
+#define HTTP_IDLE_HANDLES 64   /* Easy handles kept for reuse */
+#define HTTP_MAX_CONNECTS 128  /* Idle connections kept open */
+#define HTTP_RETRY_AFTER_DEFAULT 60    /* 429 without Retry-After */
+#define HTTP_RETRY_AFTER_MAX     3600
+
+typedef struct transfer {
+    CURL               *easy;
+    struct curl_slist  *headers;
+    mc_http_done_fn     done;
+    void               *ctx;
+    char               *body;
+    size_t              size;
+    char                error[CURL_ERROR_SIZE];
+    char                etag[MC_HTTP_MAX_VALIDATOR];
+    char                last_modified[MC_HTTP_MAX_VALIDATOR];
+    char                host[MC_HTTP_MAX_HOST];
+    int                 refused_sec;     /* Failed unsent: host paused */
+    struct transfer    *prev;
+    struct transfer    *next;
+} transfer_t;
+
+/* Timings and request budget of one host. Stats and bucket are under
+   http->mutex; the queue belongs to the engine thread. */
+typedef struct {
+    mc_http_host_stats_t stats;
+    double               connect_total_ms;
+    double               appconnect_total_ms;
+    double               total_ms;
+    int                  configured;     /* Rate set for this host by name */
+    double               rate;           /* Tokens per second, <= 0 unlimited */
+    double               burst;
+    double               tokens;
+    int64_t              refill_ms;
+    int64_t              paused_until_ms; /* Retry-After of the last 429 */
+    transfer_t          *queue_head;     /* Waiting for a token */
+    transfer_t          *queue_tail;
+} host_slot_t;
+
+struct mc_http {
+    CURLM          *multi;
+    CURLSH         *share;           /* DNS cache and TLS sessions */
+    pthread_mutex_t share_mutex;
+    int             epfd;
+    int             wakefd;          /* eventfd: new submissions or stop */
+    pthread_t       thread;
+    int             thread_active;
+    volatile int    running;
+
+    /* Engine thread only */
+    int64_t         timer_due_ms;    /* curl's next timeout, -1 for none */
+    int64_t         release_due_ms;  /* Next token for a queued request, -1 */
+    int             queued;          /* Requests waiting for a token */
+    transfer_t     *active;          /* Added to the multi handle */
+
+    pthread_mutex_t mutex;           /* Guards the fields below */
+    transfer_t     *submitted;       /* Waiting for the engine thread */
+    int             in_flight;
+    CURL           *idle[HTTP_IDLE_HANDLES];
+    int             idle_count;
+    host_slot_t     hosts[MC_HTTP_MAX_HOSTS];
+    int             host_count;
+    double          default_rate;    /* For hosts not configured by name */
+    double          default_burst;
+};
+
+static void share_lock(CURL *easy, curl_lock_data data, curl_lock_access access,
+                       void *userp)
+{
+    (void)easy; (void)data; (void)access;
+    mc_http_t *http = userp;
+    pthread_mutex_lock(&http->share_mutex);
+}
+
+static void share_unlock(CURL *easy, curl_lock_data data, void *userp)
+{
+    (void)easy; (void)data;
+    mc_http_t *http = userp;
+    pthread_mutex_unlock(&http->share_mutex);
+}
+
+static int64_t mono_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static size_t write_cb(void *ptr, size_t size, size_t nmemb, void *userdata)
+{
+    transfer_t *t = userdata;
+    size_t total = size * nmemb;
+    char *tmp = realloc(t->body, t->size + total + 1);
+    if (!tmp) return 0;
+    t->body = tmp;
+    memcpy(t->body + t->size, ptr, total);
+    t->size += total;
+    t->body[t->size] = '\0';
+    return total;
+}
+
+/* Copy the value of "Name: value\r\n" if line carries header name */
+static int header_value(const char *line, size_t len, const char *name,
+                        char *out, size_t cap)
+{
+    size_t n = strlen(name);
+    if (len <= n || line[n] != ':' || strncasecmp(line, name, n) != 0) return 0;
+    const char *v = line + n + 1;
+    const char *end = line + len;
+    while (v < end && (*v == ' ' || *v == '\t')) v++;
+    while (end > v && (end[-1] == '\r' || end[-1] == '\n' || end[-1] == ' ')) end--;
+    size_t vlen = (size_t)(end - v);
+    if (vlen >= cap) return 0;
+    memcpy(out, v, vlen);
+    out[vlen] = '\0';
+    return 1;
+}
+
+/* Keeps the cache validators of the final response */
+static size_t header_cb(char *line, size_t size, size_t nmemb, void *userdata)
+{
+    transfer_t *t = userdata;
+    size_t len = size * nmemb;
+    if (len > 5 && strncmp(line, "HTTP/", 5) == 0) {
+        /* A new response (after a redirect) replaces the last one's */
+        t->etag[0] = '\0';
+        t->last_modified[0] = '\0';
+    } else if (!header_value(line, len, "ETag", t->etag, sizeof(t->etag))) {
+        header_value(line, len, "Last-Modified", t->last_modified,
+                     sizeof(t->last_modified));
+    }
+    return len;
+}
+
+/* Keep epoll in step with the sockets curl wants watched. A socket
+   assigned non-NULL is already registered. */
+static int socket_cb(CURL *easy, curl_socket_t s, int what, void *userp,
+                     void *socketp)
+{
+    (void)easy;
+    mc_http_t *http = userp;
+
+    if (what == CURL_POLL_REMOVE) {
+        epoll_ctl(http->epfd, EPOLL_CTL_DEL, s, NULL);
+        return 0;
+    }
+
+    struct epoll_event ev = { .events = 0, .data.fd = s };
+    if (what & CURL_POLL_IN)  ev.events |= EPOLLIN;
+    if (what & CURL_POLL_OUT) ev.events |= EPOLLOUT;
+
+    if (socketp) {
+        epoll_ctl(http->epfd, EPOLL_CTL_MOD, s, &ev);
+    } else {
+        if (epoll_ctl(http->epfd, EPOLL_CTL_ADD, s, &ev) != 0 && errno == EEXIST)
+            epoll_ctl(http->epfd, EPOLL_CTL_MOD, s, &ev);
+        curl_multi_assign(http->multi, s, http);
+    }
+    return 0;
+}
+
+static int timer_cb(CURLM *multi, long timeout_ms, void *userp)
+{
+    (void)multi;
+    mc_http_t *http = userp;
+    http->timer_due_ms = timeout_ms < 0 ? -1 : mono_ms() + timeout_ms;
+    return 0;
+}
+
+/* Host part of url, without scheme, credentials or port */
+static void url_host(const char *url, char *out, size_t cap)
+{
+    const char *p = strstr(url, "://");
+    p = p ? p + 3 : url;
+    const char *at = strchr(p, '@');
+    const char *end = p + strcspn(p, "/?#");
+    if (at && at < end) p = at + 1;
+    size_t n = strcspn(p, ":/?#");
+    if (n >= cap) n = cap - 1;
+    memcpy(out, p, n);
+    out[n] = '\0';
+}
+
+/* Slot for host, created with the default budget on first use. Caller
+   holds http->mutex. NULL once MC_HTTP_MAX_HOSTS are tracked. */
+static host_slot_t *host_slot(mc_http_t *http, const char *host)
+{
+    for (int i = 0; i < http->host_count; i++)
+        if (strcmp(http->hosts[i].stats.host, host) == 0)
+            return &http->hosts[i];
+    if (http->host_count >= MC_HTTP_MAX_HOSTS) return NULL;
+
+    host_slot_t *slot = &http->hosts[http->host_count++];
+    snprintf(slot->stats.host, sizeof(slot->stats.host), "%s", host);
+    slot->rate = http->default_rate;
+    slot->burst = http->default_burst;
+    slot->tokens = slot->burst;
+    slot->refill_ms = mono_ms();
+    return slot;
+}
+
+/* Take one token from the host's bucket. Caller holds http->mutex. */
+static int take_token(host_slot_t *slot, int64_t now)
+{
+    if (slot->rate <= 0) return 1;
+    if (now > slot->refill_ms) {
+        slot->tokens += (double)(now - slot->refill_ms) * slot->rate / 1000.0;
+        if (slot->tokens > slot->burst) slot->tokens = slot->burst;
+        slot->refill_ms = now;
+    }
+    if (slot->tokens < 1.0) return 0;
+    slot->tokens -= 1.0;
+    return 1;
+}
+
+/* Seconds left in the host's Retry-After pause, 0 if none. Caller holds
+   http->mutex. */
+static int paused_sec(const host_slot_t *slot, int64_t now)
+{
+    if (slot->paused_until_ms <= now) return 0;
+    return (int)((slot->paused_until_ms - now + 999) / 1000);
+}
+
+/* Fold a finished transfer's timings into its host's totals. Caller
+   holds http->mutex. */
+static void record_timing(host_slot_t *slot, CURL *easy, CURLcode result)
+{
+    mc_http_host_stats_t *st = &slot->stats;
+    st->requests++;
+    if (result != CURLE_OK) st->failures++;
+
+    long new_conns = 0;
+    curl_off_t connect = 0, appconnect = 0, total = 0;
+    curl_easy_getinfo(easy, CURLINFO_NUM_CONNECTS, &new_conns);
+    curl_easy_getinfo(easy, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(easy, CURLINFO_APPCONNECT_TIME_T, &appconnect);
+    curl_easy_getinfo(easy, CURLINFO_TOTAL_TIME_T, &total);
+    slot->total_ms += (double)total / 1000.0;
+    st->avg_total_ms = slot->total_ms / (double)st->requests;
+
+    /* Handshake times only mean something for fresh connections */
+    if (new_conns > 0) {
+        st->new_connections++;
+        slot->connect_total_ms += (double)connect / 1000.0;
+        slot->appconnect_total_ms += (double)appconnect / 1000.0;
+        st->avg_connect_ms = slot->connect_total_ms / (double)st->new_connections;
+        st->avg_appconnect_ms = slot->appconnect_total_ms / (double)st->new_connections;
+    } else if (result == CURLE_OK) {
+        st->reused++;
+    }
+}
+
+/* 429, or 503 with Retry-After: the host asked us to back off. Returns
+   the pause in seconds, 0 for any other response. */
+static int retry_after(CURL *easy, long status)
+{
+    curl_off_t sec = 0;
+    curl_easy_getinfo(easy, CURLINFO_RETRY_AFTER, &sec);
+    if (status != 429 && !(status == 503 && sec > 0)) return 0;
+    if (sec <= 0) sec = HTTP_RETRY_AFTER_DEFAULT;
+    if (sec > HTTP_RETRY_AFTER_MAX) sec = HTTP_RETRY_AFTER_MAX;
+    return (int)sec;
+}
+
+static void finish(mc_http_t *http, transfer_t *t, CURLcode result)
+{
+    mc_http_response_t resp = {
+        .err = result == CURLE_OK ? MC_OK : MC_ERR_HTTP,
+        .body = t->body,
+        .size = t->size,
+    };
+    memcpy(resp.etag, t->etag, sizeof(resp.etag));
+    memcpy(resp.last_modified, t->last_modified, sizeof(resp.last_modified));
+    int sent = t->easy && !t->refused_sec && result != CURLE_ABORTED_BY_CALLBACK;
+    if (sent) {
+        curl_off_t wire = 0;
+        curl_easy_getinfo(t->easy, CURLINFO_RESPONSE_CODE, &resp.status);
+        curl_easy_getinfo(t->easy, CURLINFO_SIZE_DOWNLOAD_T, &wire);
+        resp.wire_size = (size_t)wire;
+        curl_multi_remove_handle(http->multi, t->easy);
+        if (result == CURLE_OK)
+            resp.retry_after_sec = retry_after(t->easy, resp.status);
+    } else if (t->easy) {
+        curl_multi_remove_handle(http->multi, t->easy);
+    }
+    if (t->refused_sec) {
+        resp.err = MC_ERR_RATE_LIMIT;
+        resp.retry_after_sec = t->refused_sec;
+        snprintf(resp.error, sizeof(resp.error),
+                 "%s rate limited, retry in %d s", t->host, t->refused_sec);
+    } else if (resp.retry_after_sec) {
+        resp.err = MC_ERR_RATE_LIMIT;
+        snprintf(resp.error, sizeof(resp.error),
+                 "HTTP %ld from %s, retry after %d s", resp.status, t->host,
+                 resp.retry_after_sec);
+    } else if (result != CURLE_OK) {
+        snprintf(resp.error, sizeof(resp.error), "%s",
+                 t->error[0] ? t->error : curl_easy_strerror(result));
+    }
+    curl_slist_free_all(t->headers);
+
+    /* Keep the handle for the next request */
+    pthread_mutex_lock(&http->mutex);
+    http->in_flight--;
+    host_slot_t *slot = host_slot(http, t->host);
+    if (slot && sent)
+        record_timing(slot, t->easy, result);
+    if (slot && t->refused_sec)
+        slot->stats.refused++;
+    if (slot && resp.retry_after_sec && !t->refused_sec) {
+        /* Every source on the host waits, not just this one */
+        int64_t until = mono_ms() + (int64_t)resp.retry_after_sec * 1000;
+        if (until > slot->paused_until_ms) {
+            slot->paused_until_ms = until;
+            MC_LOG_WARN("HTTP %ld from %s: pausing the host for %d s",
+                        resp.status, t->host, resp.retry_after_sec);
+        }
+        /* Resume from an empty bucket rather than a burst */
+        slot->tokens = 0;
+        slot->refill_ms = slot->paused_until_ms;
+        slot->stats.rate_limited++;
+    }
+    if (t->easy && http->idle_count < HTTP_IDLE_HANDLES) {
+        curl_easy_reset(t->easy);
+        http->idle[http->idle_count++] = t->easy;
+        t->easy = NULL;
+    }
+    pthread_mutex_unlock(&http->mutex);
+    if (t->easy) curl_easy_cleanup(t->easy);
+
+    t->done(t->ctx, &resp);
+    free(t);
+}
+
+static void unlink_active(mc_http_t *http, transfer_t *t)
+{
+    if (t->prev) t->prev->next = t->next;
+    else http->active = t->next;
+    if (t->next) t->next->prev = t->prev;
+}
+
+static void start(mc_http_t *http, transfer_t *t)
+{
+    CURLMcode rc = curl_multi_add_handle(http->multi, t->easy);
+    if (rc != CURLM_OK) {
+        snprintf(t->error, sizeof(t->error), "%s", curl_multi_strerror(rc));
+        finish(http, t, CURLE_FAILED_INIT);
+        return;
+    }
+    t->prev = NULL;
+    t->next = http->active;
+    if (http->active) http->active->prev = t;
+    http->active = t;
+}
+
+static void enqueue(mc_http_t *http, host_slot_t *slot, transfer_t *t)
+{
+    t->next = NULL;
+    if (slot->queue_tail) slot->queue_tail->next = t;
+    else slot->queue_head = t;
+    slot->queue_tail = t;
+    slot->stats.queued++;
+    slot->stats.throttled++;
+    http->queued++;
+}
+
+/* Start what the host budgets allow: a new submission goes out at once
+   if its host has a token and nothing queued ahead of it, otherwise it
+   waits its turn. Requests for a paused host fail without being sent. */
+static void add_submitted(mc_http_t *http)
+{
+    transfer_t *go = NULL, *refused = NULL;
+
+    pthread_mutex_lock(&http->mutex);
+    transfer_t *t = http->submitted;
+    http->submitted = NULL;
+    int64_t now = mono_ms();
+    while (t) {
+        transfer_t *next = t->next;
+        host_slot_t *slot = host_slot(http, t->host);
+        if (slot && (t->refused_sec = paused_sec(slot, now)) > 0) {
+            t->next = refused;
+            refused = t;
+        } else if (slot && (slot->queue_head || !take_token(slot, now))) {
+            enqueue(http, slot, t);
+        } else {
+            t->next = go;
+            go = t;
+        }
+        t = next;
+    }
+    pthread_mutex_unlock(&http->mutex);
+
+    for (; go; go = t) {
+        t = go->next;
+        start(http, go);
+    }
+    for (; refused; refused = t) {
+        t = refused->next;
+        finish(http, refused, CURLE_OK);
+    }
+}
+
+/* Hand queued requests their tokens and note when the next one is due */
+static void release_queued(mc_http_t *http)
+{
+    if (http->queued == 0) return;
+    transfer_t *go = NULL, *refused = NULL;
+
+    pthread_mutex_lock(&http->mutex);
+    int64_t now = mono_ms();
+    http->release_due_ms = -1;
+    for (int i = 0; i < http->host_count; i++) {
+        host_slot_t *slot = &http->hosts[i];
+        int pause = paused_sec(slot, now);
+        while (slot->queue_head && (pause > 0 || take_token(slot, now))) {
+            transfer_t *t = slot->queue_head;
+            slot->queue_head = t->next;
+            if (!slot->queue_head) slot->queue_tail = NULL;
+            slot->stats.queued--;
+            http->queued--;
+            t->refused_sec = pause;
+            if (pause) {
+                t->next = refused;
+                refused = t;
+            } else {
+                t->next = go;
+                go = t;
+            }
+        }
+        if (slot->queue_head) {
+            int64_t due = now + (int64_t)((1.0 - slot->tokens) * 1000.0 / slot->rate) + 1;
+            if (http->release_due_ms < 0 || due < http->release_due_ms)
+                http->release_due_ms = due;
+        }
+    }
+    pthread_mutex_unlock(&http->mutex);
+
+    transfer_t *t;
+    for (; go; go = t) {
+        t = go->next;
+        start(http, go);
+    }
+    for (; refused; refused = t) {
+        t = refused->next;
+        finish(http, refused, CURLE_OK);
+    }
+}
+
+static void drain_done(mc_http_t *http)
+{
+    CURLMsg *msg;
+    int left;
+    while ((msg = curl_multi_info_read(http->multi, &left))) {
+        if (msg->msg != CURLMSG_DONE) continue;
+        transfer_t *t = NULL;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&t);
+        CURLcode result = msg->data.result;
+        unlink_active(http, t);
+        finish(http, t, result);
+    }
+}
+
+static void abort_all(mc_http_t *http, transfer_t *t)
+{
+    while (t) {
+        transfer_t *next = t->next;
+        snprintf(t->error, sizeof(t->error), "HTTP engine stopped");
+        finish(http, t, CURLE_ABORTED_BY_CALLBACK);
+        t = next;
+    }
+}
+
+static void *engine_thread(void *arg)
+{
+    mc_http_t *http = arg;
+    struct epoll_event events[HTTP_EPOLL_BATCH];
+    int running_handles;
+
+    while (http->running) {
+        int64_t due = http->timer_due_ms;
+        if (http->release_due_ms >= 0 && (due < 0 || http->release_due_ms < due))
+            due = http->release_due_ms;
+        int timeout = -1;
+        if (due >= 0) {
+            int64_t wait = due - mono_ms();
+            timeout = wait > 0 ? (int)wait : 0;
+        }
+
+        int n = epoll_wait(http->epfd, events, HTTP_EPOLL_BATCH, timeout);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            MC_LOG_ERROR("HTTP engine epoll_wait: %s", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == http->wakefd) {
+                uint64_t v;
+                while (read(http->wakefd, &v, sizeof(v)) > 0) {}
+                add_submitted(http);
+                continue;
+            }
+            int mask = 0;
+            if (events[i].events & EPOLLIN)  mask |= CURL_CSELECT_IN;
+            if (events[i].events & EPOLLOUT) mask |= CURL_CSELECT_OUT;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) mask |= CURL_CSELECT_ERR;
+            curl_multi_socket_action(http->multi, fd, mask, &running_handles);
+        }
+
+        if (http->timer_due_ms >= 0 && mono_ms() >= http->timer_due_ms) {
+            http->timer_due_ms = -1;
+            curl_multi_socket_action(http->multi, CURL_SOCKET_TIMEOUT, 0,
+                                     &running_handles);
+        }
+        drain_done(http);
+        release_queued(http);
+    }
+
+    /* Handles are removed one by one so each owner hears about its request */
+    transfer_t *active = http->active;
+    http->active = NULL;
+    abort_all(http, active);
+    for (int i = 0; i < http->host_count; i++) {
+        pthread_mutex_lock(&http->mutex);
+        transfer_t *queued = http->hosts[i].queue_head;
+        http->hosts[i].queue_head = http->hosts[i].queue_tail = NULL;
+        http->hosts[i].stats.queued = 0;
+        pthread_mutex_unlock(&http->mutex);
+        abort_all(http, queued);
+    }
+    http->queued = 0;
+    return NULL;
+}
+
+mc_http_t *mc_http_create(void)
+{
+    mc_http_t *http = calloc(1, sizeof(*http));
+    if (!http) return NULL;
+
+    http->epfd = epoll_create1(EPOLL_CLOEXEC);
+    http->wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    http->multi = curl_multi_init();
+    http->share = curl_share_init();
+    http->timer_due_ms = -1;
+    http->release_due_ms = -1;
+    pthread_mutex_init(&http->mutex, NULL);
+    pthread_mutex_init(&http->share_mutex, NULL);
+
+    if (http->epfd < 0 || http->wakefd < 0 || !http->multi || !http->share) {
+        MC_LOG_ERROR("HTTP engine setup failed: %s", strerror(errno));
+        mc_http_destroy(http);
+        return NULL;
+    }
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.fd = http->wakefd };
+    epoll_ctl(http->epfd, EPOLL_CTL_ADD, http->wakefd, &ev);
+
+    curl_multi_setopt(http->multi, CURLMOPT_SOCKETFUNCTION, socket_cb);
+    curl_multi_setopt(http->multi, CURLMOPT_SOCKETDATA, http);
+    curl_multi_setopt(http->multi, CURLMOPT_TIMERFUNCTION, timer_cb);
+    curl_multi_setopt(http->multi, CURLMOPT_TIMERDATA, http);
+    curl_multi_setopt(http->multi, CURLMOPT_MAXCONNECTS, (long)HTTP_MAX_CONNECTS);
+
+    /* The multi handle already pools connections across transfers; the
+       share adds DNS answers and TLS sessions, so a reconnect to a known
+       host skips the lookup and resumes the session */
+    curl_share_setopt(http->share, CURLSHOPT_LOCKFUNC, share_lock);
+    curl_share_setopt(http->share, CURLSHOPT_UNLOCKFUNC, share_unlock);
+    curl_share_setopt(http->share, CURLSHOPT_USERDATA, http);
+    curl_share_setopt(http->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(http->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+    http->running = 1;
+    if (pthread_create(&http->thread, NULL, engine_thread, http) != 0) {
+        MC_LOG_ERROR("Failed to start HTTP engine thread");
+        mc_http_destroy(http);
+        return NULL;
+    }
+    http->thread_active = 1;
+    return http;
+}
+
+void mc_http_destroy(mc_http_t *http)
+{
+    if (!http) return;
+
+    http->running = 0;
+    if (http->thread_active) {
+        uint64_t one = 1;
+        if (write(http->wakefd, &one, sizeof(one)) < 0)
+            MC_LOG_WARN("HTTP engine wakeup: %s", strerror(errno));
+        pthread_join(http->thread, NULL);
+    }
+
+    pthread_mutex_lock(&http->mutex);
+    transfer_t *pending = http->submitted;
+    http->submitted = NULL;
+    pthread_mutex_unlock(&http->mutex);
+    abort_all(http, pending);
+
+    for (int i = 0; i < http->idle_count; i++)
+        curl_easy_cleanup(http->idle[i]);
+    if (http->multi) curl_multi_cleanup(http->multi);
+    if (http->share) curl_share_cleanup(http->share);
+    if (http->epfd >= 0) close(http->epfd);
+    if (http->wakefd >= 0) close(http->wakefd);
+    pthread_mutex_destroy(&http->mutex);
+    pthread_mutex_destroy(&http->share_mutex);
+    free(http);
+}
+
+mc_error_t mc_http_submit(mc_http_t *http, const mc_http_request_t *req,
+                          mc_http_done_fn done, void *ctx)
+{
+    transfer_t *t = calloc(1, sizeof(*t));
+    if (!t) return MC_ERR_OOM;
+
+    pthread_mutex_lock(&http->mutex);
+    if (http->idle_count > 0)
+        t->easy = http->idle[--http->idle_count];
+    pthread_mutex_unlock(&http->mutex);
+    if (!t->easy) t->easy = curl_easy_init();
+    if (!t->easy) {
+        free(t);
+        return MC_ERR_HTTP;
+    }
+    t->done = done;
+    t->ctx = ctx;
+    url_host(req->url, t->host, sizeof(t->host));
+
+    for (int i = 0; i < req->header_count; i++)
+        t->headers = curl_slist_append(t->headers, req->headers[i]);
+
+    CURL *e = t->easy;
+    curl_easy_setopt(e, CURLOPT_URL, req->url);
+    curl_easy_setopt(e, CURLOPT_WRITEFUNCTION, write_cb);
+    curl_easy_setopt(e, CURLOPT_WRITEDATA, t);
+    curl_easy_setopt(e, CURLOPT_HEADERFUNCTION, header_cb);
+    curl_easy_setopt(e, CURLOPT_HEADERDATA, t);
+    curl_easy_setopt(e, CURLOPT_PRIVATE, t);
+    curl_easy_setopt(e, CURLOPT_ERRORBUFFER, t->error);
+    curl_easy_setopt(e, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(e, CURLOPT_SHARE, http->share);
+    curl_easy_setopt(e, CURLOPT_TIMEOUT, req->timeout_sec > 0 ? req->timeout_sec : 15L);
+    curl_easy_setopt(e, CURLOPT_USERAGENT,
+                     req->user_agent ? req->user_agent : "MonitorCrebirth/0.1");
+    /* "" offers every encoding this libcurl can decode */
+    if (!req->identity_encoding)
+        curl_easy_setopt(e, CURLOPT_ACCEPT_ENCODING, "");
+    if (req->follow_location)
+        curl_easy_setopt(e, CURLOPT_FOLLOWLOCATION, 1L);
+    if (req->post_body) {
+        curl_easy_setopt(e, CURLOPT_POST, 1L);
+        curl_easy_setopt(e, CURLOPT_COPYPOSTFIELDS, req->post_body);
+    }
+    if (t->headers)
+        curl_easy_setopt(e, CURLOPT_HTTPHEADER, t->headers);
+
+    pthread_mutex_lock(&http->mutex);
+    t->next = http->submitted;
+    http->submitted = t;
+    http->in_flight++;
+    pthread_mutex_unlock(&http->mutex);
+
+    uint64_t one = 1;
+    if (write(http->wakefd, &one, sizeof(one)) < 0)
+        MC_LOG_WARN("HTTP engine wakeup: %s", strerror(errno));
+    return MC_OK;
+}
+
+void mc_http_add_header(mc_http_request_t *req, const char *header)
+{
+    if (req->header_count >= MC_HTTP_MAX_HEADERS) return;
+    snprintf(req->headers[req->header_count++], sizeof(req->headers[0]),
+             "%s", header);
+}
+
+int mc_http_in_flight(mc_http_t *http)
+{
+    pthread_mutex_lock(&http->mutex);
+    int n = http->in_flight;
+    pthread_mutex_unlock(&http->mutex);
+    return n;
+}
+
+int mc_http_get_host_stats(mc_http_t *http, mc_http_host_stats_t *out, int max_count)
+{
+    int n = 0;
+    pthread_mutex_lock(&http->mutex);
+    int64_t now = mono_ms();
+    for (int i = 0; i < http->host_count && n < max_count; i++) {
+        const host_slot_t *slot = &http->hosts[i];
+        /* Hosts named in the config but not contacted yet */
+        if (slot->stats.requests == 0 && slot->stats.queued == 0 &&
+            slot->stats.refused == 0)
+            continue;
+        out[n] = slot->stats;
+        out[n].paused_sec = paused_sec(slot, now);
+        n++;
+    }
+    pthread_mutex_unlock(&http->mutex);
+    return n;
+}
+
+static void set_budget(host_slot_t *slot, double per_sec, double burst)
+{
+    slot->rate = per_sec;
+    slot->burst = burst;
+    if (slot->tokens > burst) slot->tokens = burst;
+}
+
+void mc_http_set_rate_limit(mc_http_t *http, const char *host,
+                            double per_sec, double burst)
+{
+    if (burst < 1.0) burst = 1.0;
+    pthread_mutex_lock(&http->mutex);
+    if (host) {
+        host_slot_t *slot = host_slot(http, host);
+        if (slot) {
+            set_budget(slot, per_sec, burst);
+            slot->configured = 1;
+        } else {
+            MC_LOG_WARN("HTTP rate limit for %s ignored: too many hosts", host);
+        }
+    } else {
+        http->default_rate = per_sec;
+        http->default_burst = burst;
+        for (int i = 0; i < http->host_count; i++)
+            if (!http->hosts[i].configured)
+                set_budget(&http->hosts[i], per_sec, burst);
+    }
+    pthread_mutex_unlock(&http->mutex);
+}
@@ -0,0 +1,210 @@
+#include "mc_intern.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INTERN_CHUNK_SIZE 65536  /* Arena block; strings never move */
+
+typedef struct chunk {
+    struct chunk *next;
+    size_t        used;
+    char          data[INTERN_CHUNK_SIZE];
+} chunk_t;
+
+static pthread_rwlock_t g_lock = PTHREAD_RWLOCK_INITIALIZER;
+static const char     **g_strs;        /* id -> string, NULL for gaps */
+static uint32_t         g_count;       /* ids in use: 0 .. g_count-1 */
+static uint32_t         g_cap;
+static uint32_t        *g_slots;       /* Open addressing: id, or UINT32_MAX */
+static uint32_t         g_slot_cap;    /* Power of two */
+static chunk_t         *g_chunks;
+
+static uint32_t hash_str(const char *s)
+{
+    uint32_t h = 2166136261u;
+    for (; *s; s++) h = (h ^ (uint8_t)*s) * 16777619u;
+    return h;
+}
+
+/* Caller must hold g_lock (read or write) */
+static int64_t lookup(const char *s)
+{
+    if (!g_slot_cap) return -1;
+    uint32_t mask = g_slot_cap - 1;
+    for (uint32_t h = hash_str(s) & mask; g_slots[h] != UINT32_MAX; h = (h + 1) & mask)
+        if (strcmp(g_strs[g_slots[h]], s) == 0)
+            return g_slots[h];
+    return -1;
+}
+
+static void slot_insert(uint32_t id)
+{
+    uint32_t mask = g_slot_cap - 1;
+    uint32_t h = hash_str(g_strs[id]) & mask;
+    while (g_slots[h] != UINT32_MAX) h = (h + 1) & mask;
+    g_slots[h] = id;
+}
+
+static const char *arena_copy(const char *s)
+{
+    size_t len = strlen(s) + 1;
+    if (len > INTERN_CHUNK_SIZE) return NULL;
+    if (!g_chunks || g_chunks->used + len > INTERN_CHUNK_SIZE) {
+        chunk_t *c = malloc(sizeof(*c));
+        if (!c) return NULL;
+        c->next = g_chunks;
+        c->used = 0;
+        g_chunks = c;
+    }
+    char *p = g_chunks->data + g_chunks->used;
+    memcpy(p, s, len);
+    g_chunks->used += len;
+    return p;
+}
+
+/* Make room for ids up to and including id. Caller holds the write lock. */
+static int reserve(uint32_t id)
+{
+    if (id >= g_cap) {
+        uint32_t cap = g_cap ? g_cap : 256;
+        while (cap <= id) cap *= 2;
+        const char **strs = realloc(g_strs, cap * sizeof(*strs));
+        if (!strs) return -1;
+        memset(strs + g_cap, 0, (cap - g_cap) * sizeof(*strs));
+        g_strs = strs;
+        g_cap = cap;
+    }
+
+    /* Keep the table at most half full */
+    if ((id + 1) * 2 > g_slot_cap) {
+        uint32_t cap = g_slot_cap ? g_slot_cap : 512;
+        while ((id + 1) * 2 > cap) cap *= 2;
+        uint32_t *slots = malloc(cap * sizeof(*slots));
+        if (!slots) return -1;
+        memset(slots, 0xff, cap * sizeof(*slots));
+        free(g_slots);
+        g_slots = slots;
+        g_slot_cap = cap;
+        for (uint32_t i = 0; i < g_count; i++)
+            if (g_strs[i]) slot_insert(i);
+    }
+    return 0;
+}
+
+/* Caller holds the write lock */
+static int put(uint32_t id, const char *s)
+{
+    if (reserve(id) != 0) return -1;
+    const char *copy = arena_copy(s);
+    if (!copy) return -1;
+    g_strs[id] = copy;
+    if (id >= g_count) g_count = id + 1;
+    slot_insert(id);
+    return 0;
+}
+
+static void ensure_empty_string(void)
+{
+    if (g_count == 0) put(0, "");
+}
+
+uint32_t mc_intern(const char *s)
+{
+    if (!s || !*s) return 0;
+
+    pthread_rwlock_rdlock(&g_lock);
+    int64_t id = lookup(s);
+    pthread_rwlock_unlock(&g_lock);
+    if (id >= 0) return (uint32_t)id;
+
+    pthread_rwlock_wrlock(&g_lock);
+    ensure_empty_string();
+    id = lookup(s);
+    if (id < 0) {
+        id = g_count;
+        if (put(g_count, s) != 0) id = 0;
+    }
+    pthread_rwlock_unlock(&g_lock);
+    return (uint32_t)id;
+}
+
+const char *mc_intern_str(uint32_t id)
+{
+    pthread_rwlock_rdlock(&g_lock);
+    const char *s = id < g_count ? g_strs[id] : NULL;
+    pthread_rwlock_unlock(&g_lock);
+    return s ? s : "";
+}
+
+uint32_t mc_intern_count(void)
+{
+    pthread_rwlock_rdlock(&g_lock);
+    uint32_t n = g_count;
+    pthread_rwlock_unlock(&g_lock);
+    return n;
+}
+
+int mc_intern_restore(uint32_t id, const char *s)
+{
+    if (id == UINT32_MAX || !s) return -1;
+
+    pthread_rwlock_wrlock(&g_lock);
+    ensure_empty_string();
+    int rc;
+    if (id < g_count && g_strs[id])
+        rc = strcmp(g_strs[id], s) == 0 ? 0 : -1;
+    else
+        rc = lookup(s) >= 0 ? -1 : put(id, s);
+    pthread_rwlock_unlock(&g_lock);
+    return rc;
+}
+
+void mc_intern_shutdown(void)
+{
+    pthread_rwlock_wrlock(&g_lock);
+    while (g_chunks) {
+        chunk_t *next = g_chunks->next;
+        free(g_chunks);
+        g_chunks = next;
+    }
+    free(g_strs);
+    free(g_slots);
+    g_strs = NULL;
+    g_slots = NULL;
+    g_count = g_cap = g_slot_cap = 0;
+    pthread_rwlock_unlock(&g_lock);
+}
+
+void mc_entry_pack(const mc_data_entry_t *e, mc_entry_rec_t *out)
+{
+    out->id = e->id;
+    out->source_id = mc_intern(e->source_name);
+    out->symbol_id = mc_intern(e->symbol);
+    out->display_id = mc_intern(e->display_name);
+    out->currency_id = mc_intern(e->currency);
+    out->source_type = e->source_type;
+    out->category = e->category;
+    out->value = e->value;
+    out->change_pct = e->change_pct;
+    out->volume = e->volume;
+    out->timestamp = e->timestamp;
+    out->fetched_at = e->fetched_at;
+}
+
+void mc_entry_unpack(const mc_entry_rec_t *r, mc_data_entry_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->id = r->id;
+    strncpy(out->source_name, mc_intern_str(r->source_id), MC_MAX_SOURCE - 1);
+    strncpy(out->symbol, mc_intern_str(r->symbol_id), MC_MAX_SYMBOL - 1);
+    strncpy(out->display_name, mc_intern_str(r->display_id), MC_MAX_NAME - 1);
+    strncpy(out->currency, mc_intern_str(r->currency_id), MC_MAX_SYMBOL - 1);
+    out->source_type = r->source_type;
+    out->category = r->category;
+    out->value = r->value;
+    out->change_pct = r->change_pct;
+    out->volume = r->volume;
+    out->timestamp = r->timestamp;
+    out->fetched_at = r->fetched_at;
+}
@@ -1,5 +1,6 @@
 #include "mc_config.h"
 #include "mc_db.h"
+#include "mc_intern.h"
 #include "mc_scheduler.h"
 #include "mc_api_http.h"
 #include "mc_api_unix.h"
@@ -136,7 +137,14 @@ int main(int argc, char **argv)
     ensure_dir(cfg.unix_socket_path);
 
     /* Open database */
-    mc_db_t *db = mc_db_open(cfg.db_path);
+    mc_db_t *db;
+    if (strcmp(cfg.storage, "memory") == 0) {
+        db = mc_db_open_memory(cfg.db_path, cfg.checkpoint_interval_sec);
+    } else {
+        if (strcmp(cfg.storage, "disk") != 0)
+            MC_LOG_WARN("Unknown storage \"%s\", using disk", cfg.storage);
+        db = mc_db_open(cfg.db_path);
+    }
     if (!db) {
         MC_LOG_ERROR("Failed to open database");
         return 1;
@@ -195,6 +203,7 @@ int main(int argc, char **argv)
     mc_scheduler_stop(sched);
     mc_scheduler_destroy(sched);
     mc_db_close(db);
+    mc_intern_shutdown();
 
     xmlCleanupParser();
     curl_global_cleanup();
@@ -2,9 +2,12 @@
 #include "mc_fetch_rss.h"
 #include "mc_fetch_rest.h"
 #include "mc_fetch_ws.h"
+#include "mc_http.h"
 #include "mc_log.h"
+#include "mc_snapshot.h"
 
 #include <pthread.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -15,44 +18,96 @@
 #define PRUNE_INTERVAL_SEC  120   /* Prune DB every 2 minutes */
 #define PRUNE_MAX_AGE_SEC   1800  /* Keep data for 30 minutes */
 #define MAX_BACKOFF_SEC     300   /* Max retry backoff: 5 min */
-#define REST_WORKER_COUNT   8     /* Parallel REST fetch workers */
+#define PARSE_WORKER_COUNT  2     /* Threads parsing fetched bodies */
+#define RSS_MAX_ITEMS       64    /* Items kept per feed fetch */
+#define CALENDAR_MAX_ITEMS  256   /* Events kept per calendar fetch */
+#define SNAPSHOT_SAVE_SEC   60    /* Warm-start file refresh */
+
+/* DB maintenance cadence. Vacuum runs ahead of truncate so the pages it
+   moves leave the WAL in the same pass. */
+static const struct {
+    mc_db_maint_task_t task;
+    int                interval_sec;
+} MAINT_SCHEDULE[] = {
+    { MC_DB_MAINT_CHECKPOINT, 10 },
+    { MC_DB_MAINT_VACUUM,     PRUNE_INTERVAL_SEC },
+    { MC_DB_MAINT_TRUNCATE,   300 },
+    { MC_DB_MAINT_OPTIMIZE,   3600 },
+};
+
+#define MAINT_TASK_COUNT (int)(sizeof(MAINT_SCHEDULE) / sizeof(MAINT_SCHEDULE[0]))
 
-/* Per-source tracking for retry backoff */
+/* Per-source tracking for retry backoff and dispatch latency */
 typedef struct {
     int  consecutive_failures;
     int  backoff_sec;
     time_t last_attempt;
     time_t last_success;
+    /* Due to fetch start; written under timer_mutex */
+    uint64_t fetches;
+    int64_t  delay_last_ms;
+    int64_t  delay_max_ms;
+    int64_t  delay_total_ms;
+    /* Conditional GET: validators of the last full response, touched only
+       by the thread holding the source's fetch */
+    char     etag[MC_HTTP_MAX_VALIDATOR];
+    char     last_modified[MC_HTTP_MAX_VALIDATOR];
+    size_t   last_body_size;
+    /* 304 answers, and the body bytes they spared; under timer_mutex */
+    uint64_t not_modified;
+    uint64_t bytes_saved;
+    /* Body bytes as transferred and after content decoding; under
+       timer_mutex */
+    uint64_t bytes_wire;
+    uint64_t bytes_decoded;
+    /* Adaptive polling: digest of the last parsed content (fetch-holding
+       thread only); interval and change count under timer_mutex */
+    uint32_t digest;
+    int      have_digest;
+    int      interval_sec;
+    uint64_t changes;
+    /* Rate-limit answers from the source's host; under timer_mutex */
+    uint64_t rate_limited;
+    int64_t  rate_limited_until_ms;
 } source_health_t;
 
-/* Job queue for REST worker pool */
+/* Next fetch of one source, on CLOCK_MONOTONIC */
+typedef struct {
+    int64_t due_ms;
+    int     index;       /* Into the loop's source array */
+} source_timer_t;
+
+/* Min-heap of deadlines, one entry per source of a fetch loop */
 typedef struct {
-    int             indices[MC_MAX_SOURCES]; /* source indices to fetch */
-    int             count;                   /* total jobs in batch */
-    int             next;                    /* next job to claim */
-    pthread_mutex_t mutex;
-    pthread_cond_t  ready;                   /* signaled when jobs available */
-} rest_queue_t;
+    source_timer_t items[MC_MAX_SOURCES];
+    int            count;
+} timer_heap_t;
+
+/* A fetch handed to the HTTP engine, then queued for a parse worker */
+typedef struct fetch_job {
+    struct mc_scheduler *sched;
+    int                  rss;            /* else REST */
+    source_timer_t       timer;
+    mc_http_response_t   resp;
+    int                  changed;        /* vs last fetch; -1 unknown */
+    struct fetch_job    *next;
+} fetch_job_t;
 
 struct mc_scheduler {
     const mc_config_t *cfg;
     mc_db_t           *db;
 
     /* Background threads */
-    pthread_t          rss_thread;
-    pthread_t          rest_dispatch_thread;
-    pthread_t          rest_workers[REST_WORKER_COUNT];
-    int                rest_worker_count;
+    pthread_t          dispatch_thread;
+    pthread_t          parse_workers[PARSE_WORKER_COUNT];
+    int                parse_worker_count;
+    int                dispatch_thread_active;
     pthread_t          prune_thread;
-    int                rss_thread_active;
-    int                rest_dispatch_active;
+    pthread_t          maint_thread;
+    pthread_t          snapshot_thread;
     int                prune_thread_active;
-
-    /* REST worker pool */
-    rest_queue_t       rest_queue;
-    int                rest_pending;         /* jobs still in progress */
-    pthread_mutex_t    rest_done_mutex;
-    pthread_cond_t     rest_done_cond;       /* signaled when batch complete */
+    int                maint_thread_active;
+    int                snapshot_thread_active;
 
     /* WebSocket connections */
     mc_ws_conn_t      *ws_conns[MC_MAX_SOURCES];
@@ -62,19 +117,47 @@ struct mc_scheduler {
     source_health_t    rss_health[MC_MAX_SOURCES];
     source_health_t    rest_health[MC_MAX_SOURCES];
 
+    /* Fetch deadlines. Every background loop sleeps on timer_cond (a
+       monotonic condvar), which is broadcast on stop and force refresh. */
+    pthread_mutex_t    timer_mutex;
+    pthread_cond_t     timer_cond;
+    timer_heap_t       rss_timers;
+    timer_heap_t       rest_timers;
+    int                rss_in_flight;        /* Capped at cfg->rss_workers */
+
+    /* HTTP transfers run on the engine thread; bodies come back through
+       parse_queue to the parse workers */
+    mc_http_t         *http;
+    pthread_mutex_t    parse_mutex;
+    pthread_cond_t     parse_cond;
+    fetch_job_t       *parse_head;
+    fetch_job_t       *parse_tail;
+
+    /* Cold start: feeds not yet fetched once, under timer_mutex */
+    int64_t            started_ms;
+    int                rss_first_pending;
+    int64_t            rss_first_pass_ms;    /* -1 until every feed is in */
+
     /* Shared snapshot for API consumers */
     pthread_rwlock_t   snapshot_lock;
-    mc_data_entry_t    entries[MAX_SNAPSHOT_ENTRIES];
+    mc_entry_rec_t     entries[MAX_SNAPSHOT_ENTRIES];
     int                entry_count;
-    mc_news_item_t     news[MAX_SNAPSHOT_NEWS];
+    mc_news_rec_t     *news;                 /* MAX_SNAPSHOT_NEWS, swapped whole */
     int                news_count;
+    time_t             snapshot_built_at;
+    int                snapshot_warm;        /* Still the warm-start file's data */
+
+    /* Warm-start file, rewritten every SNAPSHOT_SAVE_SEC and on stop */
+    char               snapshot_path[MC_MAX_PATH + 16];
+    time_t             last_save_time;
 
     volatile int       running;
-    volatile int       force_refresh;
 
-    /* Global snapshot throttle */
-    volatile time_t    last_snapshot_time;
-    pthread_mutex_t    snapshot_throttle_mutex;
+    /* Snapshot rebuild requests (from DB commits and pruning) */
+    time_t             last_snapshot_time;
+    int                snapshot_dirty;
+    pthread_mutex_t    snapshot_req_mutex;
+    pthread_cond_t     snapshot_req_cond;
 };
 
 static double time_decay_factor(time_t published_at)
@@ -91,7 +174,7 @@ static double time_decay_factor(time_t published_at)
 
 static int cmp_news_score(const void *a, const void *b)
 {
-    const mc_news_item_t *na = a, *nb = b;
+    const mc_news_rec_t *na = a, *nb = b;
     if (nb->score != na->score)
         return (nb->score > na->score) ? 1 : -1;
     if (nb->published_at != na->published_at)
@@ -103,21 +186,17 @@ static int cmp_news_score(const void *a, const void *b)
 
 static void update_snapshot(mc_scheduler_t *sched)
 {
-    /* Global throttle: skip if called less than 5s ago */
-    time_t now = time(NULL);
-    pthread_mutex_lock(&sched->snapshot_throttle_mutex);
-    if (now - sched->last_snapshot_time < SNAPSHOT_THROTTLE_SEC) {
-        pthread_mutex_unlock(&sched->snapshot_throttle_mutex);
-        return;
-    }
-    sched->last_snapshot_time = now;
-    pthread_mutex_unlock(&sched->snapshot_throttle_mutex);
-
     /* Query DB into temp buffers WITHOUT holding the snapshot lock,
        so API readers are never blocked by slow DB queries */
     mc_data_entry_t *tmp_entries = malloc(MAX_SNAPSHOT_ENTRIES * sizeof(mc_data_entry_t));
-    mc_news_item_t *tmp_news = malloc(MAX_SNAPSHOT_NEWS * sizeof(mc_news_item_t));
-    if (!tmp_entries || !tmp_news) { free(tmp_entries); free(tmp_news); return; }
+    mc_entry_rec_t *tmp_recs = malloc(MAX_SNAPSHOT_ENTRIES * sizeof(mc_entry_rec_t));
+    mc_news_rec_t *tmp_news = malloc(MAX_SNAPSHOT_NEWS * sizeof(mc_news_rec_t));
+    if (!tmp_entries || !tmp_recs || !tmp_news) {
+        free(tmp_entries);
+        free(tmp_recs);
+        free(tmp_news);
+        return;
+    }
 
     int tmp_entry_count = 0;
     for (int cat = MC_CAT_CRYPTO; cat <= MC_CAT_CRYPTO_EXCHANGE; cat++) {
@@ -127,38 +206,121 @@ static void update_snapshot(mc_scheduler_t *sched)
                     &tmp_entries[tmp_entry_count], remaining);
         tmp_entry_count += n;
     }
+    for (int i = 0; i < tmp_entry_count; i++)
+        mc_entry_pack(&tmp_entries[i], &tmp_recs[i]);
+    free(tmp_entries);
 
-    int tmp_news_count = mc_db_get_all_latest_news(sched->db,
+    int tmp_news_count = mc_db_get_all_latest_news_recs(sched->db,
                             tmp_news, MAX_SNAPSHOT_NEWS);
 
     /* Apply time decay to news scores and sort by final score */
     for (int i = 0; i < tmp_news_count; i++)
         tmp_news[i].score *= time_decay_factor(tmp_news[i].published_at);
     if (tmp_news_count > 1)
-        qsort(tmp_news, tmp_news_count, sizeof(mc_news_item_t), cmp_news_score);
+        qsort(tmp_news, tmp_news_count, sizeof(mc_news_rec_t), cmp_news_score);
 
-    /* Hold write lock only for the fast memcpy */
+    /* Hold write lock only for the memcpy and the news buffer swap */
     pthread_rwlock_wrlock(&sched->snapshot_lock);
-    memcpy(sched->entries, tmp_entries, tmp_entry_count * sizeof(mc_data_entry_t));
+    memcpy(sched->entries, tmp_recs, tmp_entry_count * sizeof(mc_entry_rec_t));
     sched->entry_count = tmp_entry_count;
-    memcpy(sched->news, tmp_news, tmp_news_count * sizeof(mc_news_item_t));
+    mc_news_rec_t *old_news = sched->news;
+    int old_news_count = sched->news_count;
+    sched->news = tmp_news;
     sched->news_count = tmp_news_count;
+    sched->snapshot_built_at = time(NULL);
+    sched->snapshot_warm = 0;
     pthread_rwlock_unlock(&sched->snapshot_lock);
 
-    free(tmp_entries);
-    free(tmp_news);
+    free(tmp_recs);
+    mc_news_rec_free(old_news, old_news_count);
+    free(old_news);
 }
 
-static int should_skip_source(source_health_t *h, int force)
+/* Persist the snapshot for the next start. Skipped while it is still the
+   loaded warm copy or empty, so a quick restart cannot clobber the file. */
+static void save_snapshot(mc_scheduler_t *sched)
 {
-    if (force) return 0;
-    if (h->consecutive_failures == 0) return 0;
+    pthread_rwlock_rdlock(&sched->snapshot_lock);
+    if (!sched->snapshot_warm && sched->entry_count + sched->news_count > 0)
+        mc_snapshot_save(sched->snapshot_path, sched->snapshot_built_at,
+                         sched->entries, sched->entry_count,
+                         sched->news, sched->news_count);
+    pthread_rwlock_unlock(&sched->snapshot_lock);
+    sched->last_save_time = time(NULL);
+}
 
-    time_t now = time(NULL);
-    if (now - h->last_attempt < h->backoff_sec) {
-        return 1; /* Still in backoff period */
+/* Serve the previous run's snapshot until the first rebuild replaces it.
+   Runs before any thread that touches the snapshot is started. */
+static void load_snapshot(mc_scheduler_t *sched)
+{
+    time_t built_at = 0;
+    int entry_count = 0, news_count = 0;
+    mc_error_t err = mc_snapshot_load(sched->snapshot_path, &built_at,
+                                      sched->entries, &entry_count, MAX_SNAPSHOT_ENTRIES,
+                                      sched->news, &news_count, MAX_SNAPSHOT_NEWS);
+    if (err == MC_ERR_NOT_FOUND) return;
+    if (err != MC_OK) {
+        MC_LOG_WARN("Ignoring warm-start snapshot %s: %s",
+                    sched->snapshot_path, mc_error_str(err));
+        return;
     }
-    return 0;
+
+    sched->entry_count = entry_count;
+    sched->news_count = news_count;
+    sched->snapshot_built_at = built_at;
+    sched->snapshot_warm = 1;
+    MC_LOG_INFO("Warm start: %d entries, %d news from %ld s ago",
+                entry_count, news_count, (long)(time(NULL) - built_at));
+}
+
+/* Ask the snapshot thread for a rebuild; never blocks on the DB */
+static void request_snapshot(mc_scheduler_t *sched)
+{
+    pthread_mutex_lock(&sched->snapshot_req_mutex);
+    sched->snapshot_dirty = 1;
+    pthread_cond_signal(&sched->snapshot_req_cond);
+    pthread_mutex_unlock(&sched->snapshot_req_mutex);
+}
+
+/* Called on the DB writer thread once a group of rows is committed */
+static void db_commit_callback(void *ctx)
+{
+    request_snapshot(ctx);
+}
+
+/* Background thread: rebuild the snapshot when requested, at most once
+   every SNAPSHOT_THROTTLE_SEC; requests arriving meanwhile are coalesced */
+static void *snapshot_thread_func(void *arg)
+{
+    mc_scheduler_t *sched = arg;
+
+    pthread_mutex_lock(&sched->snapshot_req_mutex);
+    while (sched->running) {
+        if (!sched->snapshot_dirty) {
+            pthread_cond_wait(&sched->snapshot_req_cond, &sched->snapshot_req_mutex);
+            continue;
+        }
+
+        time_t next = sched->last_snapshot_time + SNAPSHOT_THROTTLE_SEC;
+        if (time(NULL) < next) {
+            struct timespec ts = { .tv_sec = next, .tv_nsec = 0 };
+            pthread_cond_timedwait(&sched->snapshot_req_cond,
+                                   &sched->snapshot_req_mutex, &ts);
+            continue;
+        }
+
+        sched->snapshot_dirty = 0;
+        sched->last_snapshot_time = time(NULL);
+        pthread_mutex_unlock(&sched->snapshot_req_mutex);
+
+        update_snapshot(sched);
+        if (sched->last_snapshot_time - sched->last_save_time >= SNAPSHOT_SAVE_SEC)
+            save_snapshot(sched);
+
+        pthread_mutex_lock(&sched->snapshot_req_mutex);
+    }
+    pthread_mutex_unlock(&sched->snapshot_req_mutex);
+    return NULL;
 }
 
 static void record_success(source_health_t *h)
@@ -185,226 +347,539 @@ static void record_failure(source_health_t *h, const char *name)
                 name, h->consecutive_failures, h->backoff_sec);
 }
 
-static void sleep_interruptible(mc_scheduler_t *sched, int seconds)
+static int64_t mono_ms(void)
 {
-    for (int s = 0; s < seconds && sched->running; s++) {
-        if (sched->force_refresh) {
-            sched->force_refresh = 0;
-            break;
-        }
-        sleep(1);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void heap_push(timer_heap_t *heap, int64_t due_ms, int index)
+{
+    int i = heap->count++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (heap->items[parent].due_ms <= due_ms) break;
+        heap->items[i] = heap->items[parent];
+        i = parent;
     }
+    heap->items[i] = (source_timer_t){ due_ms, index };
 }
 
-static int source_due(source_health_t *h, int interval_sec, int force)
+static source_timer_t heap_pop(timer_heap_t *heap)
 {
-    if (force) return 1;
-    if (h->last_attempt == 0) return 1; /* Never fetched */
-    time_t now = time(NULL);
-    return (now - h->last_attempt >= interval_sec);
+    source_timer_t top = heap->items[0];
+    source_timer_t last = heap->items[--heap->count];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= heap->count) break;
+        if (child + 1 < heap->count && heap->items[child + 1].due_ms < heap->items[child].due_ms)
+            child++;
+        if (last.due_ms <= heap->items[child].due_ms) break;
+        heap->items[i] = heap->items[child];
+        i = child;
+    }
+    if (heap->count > 0) heap->items[i] = last;
+    return top;
 }
 
-static void *rss_thread_func(void *arg)
+/* Block until until_ms (CLOCK_MONOTONIC) or a broadcast on timer_cond.
+   Caller holds timer_mutex. */
+static void timer_wait(mc_scheduler_t *sched, int64_t until_ms)
 {
-    mc_scheduler_t *sched = arg;
-    mc_news_item_t items[64];
+    struct timespec ts = {
+        .tv_sec = (time_t)(until_ms / 1000),
+        .tv_nsec = (long)(until_ms % 1000) * 1000000L,
+    };
+    pthread_cond_timedwait(&sched->timer_cond, &sched->timer_mutex, &ts);
+}
 
-    while (sched->running) {
-        int any_fetched = 0;
-
-        for (int i = 0; i < sched->cfg->rss_count && sched->running; i++) {
-            const mc_rss_source_cfg_t *src = &sched->cfg->rss_sources[i];
-            source_health_t *h = &sched->rss_health[i];
-
-            if (should_skip_source(h, sched->force_refresh))
-                continue;
-            if (!source_due(h, src->refresh_interval_sec, sched->force_refresh))
-                continue;
-
-            int n = mc_fetch_rss(src, items, 64);
-            if (n > 0) {
-                for (int j = 0; j < n; j++)
-                    mc_db_insert_news(sched->db, &items[j]);
-                mc_db_update_source_status(sched->db, src->name,
-                                           MC_SOURCE_RSS, NULL);
-                record_success(h);
-                any_fetched = 1;
-            } else if (n == 0) {
-                h->last_attempt = time(NULL);
-            } else {
-                mc_db_update_source_status(sched->db, src->name,
-                                           MC_SOURCE_RSS, "fetch failed");
-                record_failure(h, src->name);
-            }
-        }
+/* Sleep for ms, returning early (0) once the scheduler stops */
+static int sched_sleep(mc_scheduler_t *sched, int64_t ms)
+{
+    int64_t until = mono_ms() + ms;
+    pthread_mutex_lock(&sched->timer_mutex);
+    while (sched->running && mono_ms() < until)
+        timer_wait(sched, until);
+    pthread_mutex_unlock(&sched->timer_mutex);
+    return sched->running;
+}
+
+/* Pop the due source on top of heap and note how late it starts.
+   Caller holds timer_mutex. */
+static source_timer_t timer_claim(timer_heap_t *heap, source_health_t *health)
+{
+    source_timer_t t = heap_pop(heap);
+    source_health_t *h = &health[t.index];
+    int64_t delay = mono_ms() - t.due_ms;
+    h->fetches++;
+    h->delay_last_ms = delay;
+    h->delay_total_ms += delay;
+    if (delay > h->delay_max_ms) h->delay_max_ms = delay;
+    return t;
+}
+
+/* Queue the next fetch of a source. A deadline earlier than the one the
+   dispatcher sleeps towards must wake it. Caller holds timer_mutex. */
+static void timer_requeue(mc_scheduler_t *sched, timer_heap_t *heap,
+                          int64_t due_ms, int index)
+{
+    heap_push(heap, due_ms, index);
+    if (heap->items[0].index == index)
+        pthread_cond_broadcast(&sched->timer_cond);
+}
 
-        if (any_fetched)
-            update_snapshot(sched);
+/* Deadline after a fetch that was due at due_ms. Success keeps the
+   cadence of the original schedule, skipping slots the fetch overran;
+   failure waits out its backoff from now. */
+static int64_t next_due(const source_health_t *h, int64_t due_ms, int interval_sec)
+{
+    int64_t now = mono_ms();
+    if (h->consecutive_failures > 0)
+        return now + (int64_t)h->backoff_sec * 1000;
+
+    int64_t step = (int64_t)(interval_sec > 0 ? interval_sec : 1) * 1000;
+    int64_t next = due_ms + step;
+    if (next <= now)
+        next += ((now - next) / step + 1) * step;
+    return next;
+}
 
-        /* Sleep 5s between checks (per-source intervals handle timing) */
-        sleep_interruptible(sched, 5);
+/* Upper bound of an adaptive interval: past half the retention, prune
+   would drop the source's rows between two fetches */
+static int adaptive_max(int min_sec, int max_sec)
+{
+    if (max_sec <= PRUNE_MAX_AGE_SEC / 2) return max_sec;
+    return min_sec > PRUNE_MAX_AGE_SEC / 2 ? min_sec : PRUNE_MAX_AGE_SEC / 2;
+}
+
+/* Halve the interval after a fetch that brought new content, stretch it
+   by a quarter after one that did not, so a source settles near its own
+   change period within its configured bounds. Caller holds timer_mutex. */
+static void adapt_interval(source_health_t *h, int changed, int min_sec, int max_sec)
+{
+    if (changed > 0) h->changes++;
+    if (changed < 0 || max_sec <= min_sec) return;
+    max_sec = adaptive_max(min_sec, max_sec);
+
+    int next = changed ? h->interval_sec / 2
+                       : h->interval_sec + (h->interval_sec + 3) / 4;
+    if (next < min_sec) next = min_sec;
+    if (next > max_sec) next = max_sec;
+    h->interval_sec = next;
+}
+
+/* ── Fetch pipeline ── */
+
+static uint32_t fnv1a(uint32_t h, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    for (size_t i = 0; i < len; i++) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+/* Title and link only: undated items are stamped with the fetch time */
+static uint32_t news_digest(const mc_news_item_t *items, int n)
+{
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < n; i++) {
+        h = fnv1a(h, items[i].title, strlen(items[i].title) + 1);
+        h = fnv1a(h, items[i].url, strlen(items[i].url) + 1);
     }
+    return h;
+}
 
-    return NULL;
+/* Quote values only: fetch and exchange timestamps move on every poll */
+static uint32_t entries_digest(const mc_data_entry_t *entries, int n)
+{
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < n; i++) {
+        h = fnv1a(h, entries[i].symbol, strlen(entries[i].symbol) + 1);
+        h = fnv1a(h, &entries[i].value, sizeof(entries[i].value));
+        h = fnv1a(h, &entries[i].change_pct, sizeof(entries[i].change_pct));
+        h = fnv1a(h, &entries[i].volume, sizeof(entries[i].volume));
+    }
+    return h;
 }
 
-/* ── REST worker pool ── */
+/* Compare a parsed fetch with the previous one; the first is unknown */
+static int note_digest(source_health_t *h, uint32_t digest)
+{
+    int changed = h->have_digest ? digest != h->digest : -1;
+    h->digest = digest;
+    h->have_digest = 1;
+    return changed;
+}
 
-static void *rest_worker_func(void *arg)
+/* Count a feed's first fetch towards the cold-start news set.
+   Caller holds timer_mutex. */
+static void note_first_rss(mc_scheduler_t *sched, const source_health_t *h)
 {
-    mc_scheduler_t *sched = arg;
-    mc_data_entry_t *entries = malloc(MAX_SNAPSHOT_ENTRIES * sizeof(mc_data_entry_t));
-    if (!entries) return NULL;
+    if (h->fetches != 1 || sched->rss_first_pending <= 0) return;
+    if (--sched->rss_first_pending > 0) return;
 
-    while (sched->running) {
-        /* Wait for jobs */
-        pthread_mutex_lock(&sched->rest_queue.mutex);
-        while (sched->rest_queue.next >= sched->rest_queue.count && sched->running)
-            pthread_cond_wait(&sched->rest_queue.ready, &sched->rest_queue.mutex);
+    sched->rss_first_pass_ms = mono_ms() - sched->started_ms;
+    MC_LOG_INFO("All %d RSS feeds fetched %.1f s after start",
+                sched->cfg->rss_count, (double)sched->rss_first_pass_ms / 1000.0);
+}
 
-        if (!sched->running) {
-            pthread_mutex_unlock(&sched->rest_queue.mutex);
-            break;
-        }
+/* Store a parsed fetch and update the source's health. n < 0 means the
+   fetch failed. */
+static void record_fetch(mc_scheduler_t *sched, const char *name,
+                         mc_source_type_t type, source_health_t *h, int n)
+{
+    if (n > 0) {
+        mc_db_update_source_status(sched->db, name, type, NULL);
+        record_success(h);
+    } else if (n == 0) {
+        h->last_attempt = time(NULL);
+    } else {
+        mc_db_update_source_status(sched->db, name, type, "fetch failed");
+        record_failure(h, name);
+    }
+}
 
-        /* Claim a job */
-        int idx = sched->rest_queue.indices[sched->rest_queue.next++];
-        pthread_mutex_unlock(&sched->rest_queue.mutex);
+/* The host answered 429 (or is still paused after one): wait out its
+   Retry-After instead of the exponential backoff */
+static void record_rate_limited(mc_scheduler_t *sched, const char *name,
+                                mc_source_type_t type, source_health_t *h,
+                                const mc_http_response_t *resp)
+{
+    char status[64];
+    snprintf(status, sizeof(status), "rate limited, retry in %d s",
+             resp->retry_after_sec);
+    mc_db_update_source_status(sched->db, name, type, status);
+    h->consecutive_failures++;
+    h->last_attempt = time(NULL);
+    h->backoff_sec = resp->retry_after_sec;
+    MC_LOG_WARN("Source %s: %s", name, resp->error);
+}
 
-        /* Fetch */
-        const mc_rest_source_cfg_t *src = &sched->cfg->rest_sources[idx];
-        source_health_t *h = &sched->rest_health[idx];
+static int is_not_modified(const fetch_job_t *job)
+{
+    return job->resp.err == MC_OK && job->resp.status == 304;
+}
 
-        /* Calendar sources produce news items, not data entries */
-        if (src->category == MC_CAT_FINANCIAL_NEWS) {
-            mc_news_item_t *cal_news = malloc(256 * sizeof(mc_news_item_t));
-            if (cal_news) {
-                int n = mc_fetch_rest_calendar(src, cal_news, 256);
-                MC_LOG_DEBUG("Calendar: %s returned %d events", src->name, n);
-                if (n > 0) {
-                    for (int j = 0; j < n; j++) {
-                        mc_error_t err = mc_db_insert_news(sched->db, &cal_news[j]);
-                        if (err != MC_OK)
-                            MC_LOG_ERROR("Calendar insert failed for: %s", cal_news[j].title);
-                    }
-                    mc_db_update_source_status(sched->db, src->name,
-                                               MC_SOURCE_REST, NULL);
-                    record_success(h);
-                } else if (n == 0) {
-                    h->last_attempt = time(NULL);
-                } else {
-                    mc_db_update_source_status(sched->db, src->name,
-                                               MC_SOURCE_REST, "fetch failed");
-                    record_failure(h, src->name);
-                }
-                free(cal_news);
-            }
-        } else {
-            int n = mc_fetch_rest(src, entries, MAX_SNAPSHOT_ENTRIES);
-            if (n > 0) {
-                for (int j = 0; j < n; j++)
-                    mc_db_insert_entry(sched->db, &entries[j]);
-                mc_db_update_source_status(sched->db, src->name,
-                                           MC_SOURCE_REST, NULL);
-                record_success(h);
-            } else if (n == 0) {
-                h->last_attempt = time(NULL);
-            } else {
-                mc_db_update_source_status(sched->db, src->name,
-                                           MC_SOURCE_REST, "fetch failed");
-                record_failure(h, src->name);
-            }
-        }
+/* A 304 means the stored rows are current: nothing to parse or insert.
+   Their fetch time still moves on so the age prune keeps them, and the
+   source's status row is only touched to clear an error. */
+static void record_not_modified(mc_scheduler_t *sched, const char *name,
+                                mc_source_type_t type, int news,
+                                source_health_t *h)
+{
+    mc_db_touch_source(sched->db, name, news);
+    if (h->consecutive_failures > 0)
+        mc_db_update_source_status(sched->db, name, type, NULL);
+    record_success(h);
+}
 
-        /* Signal batch progress */
-        pthread_mutex_lock(&sched->rest_done_mutex);
-        sched->rest_pending--;
-        if (sched->rest_pending == 0)
-            pthread_cond_signal(&sched->rest_done_cond);
-        pthread_mutex_unlock(&sched->rest_done_mutex);
+/* Keep the validators of a full 200 response that parsed into n items
+   for the next request. The parsers report a malformed body as 0 items,
+   so n <= 0 drops them instead: the next fetch gets the whole body again
+   rather than a 304 taken as success. */
+static void remember_validators(source_health_t *h, const mc_http_response_t *resp,
+                                int n)
+{
+    if (resp->err != MC_OK || resp->status != 200) return;
+    if (n <= 0) {
+        h->etag[0] = '\0';
+        h->last_modified[0] = '\0';
+        h->last_body_size = 0;
+        return;
     }
+    memcpy(h->etag, resp->etag, sizeof(h->etag));
+    memcpy(h->last_modified, resp->last_modified, sizeof(h->last_modified));
+    h->last_body_size = resp->size;
+}
 
-    free(entries);
-    return NULL;
+static void parse_rss(mc_scheduler_t *sched, fetch_job_t *job,
+                      mc_news_item_t *news)
+{
+    const mc_rss_source_cfg_t *src = &sched->cfg->rss_sources[job->timer.index];
+    source_health_t *h = &sched->rss_health[job->timer.index];
+    job->changed = -1;
+    if (is_not_modified(job)) {
+        job->changed = 0;
+        record_not_modified(sched, src->name, MC_SOURCE_RSS, 1, h);
+        return;
+    }
+    if (job->resp.err == MC_ERR_RATE_LIMIT) {
+        record_rate_limited(sched, src->name, MC_SOURCE_RSS, h, &job->resp);
+        return;
+    }
+    int n = -1;
+    if (job->resp.err == MC_OK) {
+        n = mc_fetch_rss_parse(src, job->resp.body, job->resp.size,
+                               news, RSS_MAX_ITEMS);
+        if (n > 0) mc_db_insert_news_batch(sched->db, news, n);
+        if (n >= 0) job->changed = note_digest(h, news_digest(news, n));
+    } else {
+        MC_LOG_ERROR("RSS fetch failed for %s: %s", src->name, job->resp.error);
+    }
+    remember_validators(h, &job->resp, n);
+    record_fetch(sched, src->name, MC_SOURCE_RSS, h, n);
 }
 
-static void *rest_dispatch_func(void *arg)
+static void parse_rest(mc_scheduler_t *sched, fetch_job_t *job,
+                       mc_data_entry_t *entries, mc_news_item_t *news)
 {
-    mc_scheduler_t *sched = arg;
+    const mc_rest_source_cfg_t *src = &sched->cfg->rest_sources[job->timer.index];
+    source_health_t *h = &sched->rest_health[job->timer.index];
+    job->changed = -1;
+    if (is_not_modified(job)) {
+        job->changed = 0;
+        record_not_modified(sched, src->name, MC_SOURCE_REST,
+                            src->category == MC_CAT_FINANCIAL_NEWS, h);
+        return;
+    }
+    if (job->resp.err == MC_ERR_RATE_LIMIT) {
+        record_rate_limited(sched, src->name, MC_SOURCE_REST, h, &job->resp);
+        return;
+    }
+    int n = -1;
+    if (job->resp.err != MC_OK) {
+        MC_LOG_ERROR("REST fetch failed for %s: %s", src->name, job->resp.error);
+    } else if (src->category == MC_CAT_FINANCIAL_NEWS) {
+        /* Calendar sources produce news items, not data entries */
+        n = mc_fetch_rest_calendar_parse(src, job->resp.body, news, CALENDAR_MAX_ITEMS);
+        if (n > 0 && mc_db_insert_news_batch(sched->db, news, n) != MC_OK)
+            MC_LOG_ERROR("Calendar insert failed for: %s", src->name);
+        if (n >= 0) job->changed = note_digest(h, news_digest(news, n));
+    } else {
+        n = mc_fetch_rest_parse(src, job->resp.body, entries, MAX_SNAPSHOT_ENTRIES);
+        if (n > 0) mc_db_insert_entries_batch(sched->db, entries, n);
+        if (n >= 0) job->changed = note_digest(h, entries_digest(entries, n));
+    }
+    remember_validators(h, &job->resp, n);
+    record_fetch(sched, src->name, MC_SOURCE_REST, h, n);
+}
 
-    while (sched->running) {
-        /* Build batch of due sources */
-        pthread_mutex_lock(&sched->rest_queue.mutex);
-        sched->rest_queue.count = 0;
-        sched->rest_queue.next = 0;
+/* Put a fetched source back on its heap */
+static void finish_job(mc_scheduler_t *sched, fetch_job_t *job)
+{
+    int idx = job->timer.index;
+    source_health_t *h = job->rss ? &sched->rss_health[idx] : &sched->rest_health[idx];
+    pthread_mutex_lock(&sched->timer_mutex);
+    if (is_not_modified(job)) {
+        h->not_modified++;
+        h->bytes_saved += h->last_body_size;
+    }
+    h->bytes_wire += job->resp.wire_size;
+    h->bytes_decoded += job->resp.size;
+    if (job->resp.err == MC_ERR_RATE_LIMIT) {
+        h->rate_limited++;
+        h->rate_limited_until_ms = mono_ms() + (int64_t)job->resp.retry_after_sec * 1000;
+    }
+    if (job->rss) {
+        const mc_rss_source_cfg_t *src = &sched->cfg->rss_sources[idx];
+        note_first_rss(sched, h);
+        /* A freed slot may unblock a due feed */
+        if (sched->rss_in_flight-- == sched->cfg->rss_workers)
+            pthread_cond_broadcast(&sched->timer_cond);
+        adapt_interval(h, job->changed, src->refresh_min_sec, src->refresh_max_sec);
+        timer_requeue(sched, &sched->rss_timers,
+                      next_due(h, job->timer.due_ms, h->interval_sec), idx);
+    } else {
+        const mc_rest_source_cfg_t *src = &sched->cfg->rest_sources[idx];
+        adapt_interval(h, job->changed, src->refresh_min_sec, src->refresh_max_sec);
+        timer_requeue(sched, &sched->rest_timers,
+                      next_due(h, job->timer.due_ms, h->interval_sec), idx);
+    }
+    pthread_mutex_unlock(&sched->timer_mutex);
+}
 
-        for (int i = 0; i < sched->cfg->rest_count; i++) {
-            source_health_t *h = &sched->rest_health[i];
-            const mc_rest_source_cfg_t *src = &sched->cfg->rest_sources[i];
+/* Engine thread: queue the body for a parse worker and return */
+static void fetch_done(void *ctx, mc_http_response_t *resp)
+{
+    fetch_job_t *job = ctx;
+    mc_scheduler_t *sched = job->sched;
+    job->resp = *resp;
+    job->next = NULL;
+
+    pthread_mutex_lock(&sched->parse_mutex);
+    if (sched->parse_tail) sched->parse_tail->next = job;
+    else sched->parse_head = job;
+    sched->parse_tail = job;
+    pthread_cond_signal(&sched->parse_cond);
+    pthread_mutex_unlock(&sched->parse_mutex);
+}
 
-            if (should_skip_source(h, sched->force_refresh))
-                continue;
-            if (!source_due(h, src->refresh_interval_sec, sched->force_refresh))
-                continue;
+static void *parse_worker_func(void *arg)
+{
+    mc_scheduler_t *sched = arg;
+    mc_data_entry_t *entries = malloc(MAX_SNAPSHOT_ENTRIES * sizeof(mc_data_entry_t));
+    mc_news_item_t *news = malloc(CALENDAR_MAX_ITEMS * sizeof(mc_news_item_t));
+    if (!entries || !news) {
+        MC_LOG_ERROR("Parse worker: out of memory");
+        free(entries);
+        free(news);
+        return NULL;
+    }
 
-            sched->rest_queue.indices[sched->rest_queue.count++] = i;
+    for (;;) {
+        pthread_mutex_lock(&sched->parse_mutex);
+        while (!sched->parse_head && sched->running)
+            pthread_cond_wait(&sched->parse_cond, &sched->parse_mutex);
+        if (!sched->running) {
+            pthread_mutex_unlock(&sched->parse_mutex);
+            break;
         }
+        fetch_job_t *job = sched->parse_head;
+        sched->parse_head = job->next;
+        if (!sched->parse_head) sched->parse_tail = NULL;
+        pthread_mutex_unlock(&sched->parse_mutex);
+
+        if (job->rss) parse_rss(sched, job, news);
+        else parse_rest(sched, job, entries, news);
+        finish_job(sched, job);
+        free(job->resp.body);
+        free(job);
+    }
 
-        int batch_size = sched->rest_queue.count;
-        pthread_mutex_unlock(&sched->rest_queue.mutex);
-
-        if (batch_size > 0) {
-            /* Set pending counter and wake workers */
-            pthread_mutex_lock(&sched->rest_done_mutex);
-            sched->rest_pending = batch_size;
-            pthread_mutex_unlock(&sched->rest_done_mutex);
-
-            pthread_mutex_lock(&sched->rest_queue.mutex);
-            pthread_cond_broadcast(&sched->rest_queue.ready);
-            pthread_mutex_unlock(&sched->rest_queue.mutex);
-
-            /* Wait for all workers to finish */
-            pthread_mutex_lock(&sched->rest_done_mutex);
-            while (sched->rest_pending > 0 && sched->running) {
-                struct timespec ts;
-                clock_gettime(CLOCK_REALTIME, &ts);
-                ts.tv_sec += 3;
-                pthread_cond_timedwait(&sched->rest_done_cond,
-                                       &sched->rest_done_mutex, &ts);
-            }
-            pthread_mutex_unlock(&sched->rest_done_mutex);
+    free(entries);
+    free(news);
+    return NULL;
+}
 
-            update_snapshot(sched);
-            MC_LOG_INFO("REST batch: %d sources fetched in parallel", batch_size);
+static void submit_fetch(mc_scheduler_t *sched, int rss, source_timer_t t)
+{
+    mc_http_request_t req;
+    if (rss) mc_fetch_rss_request(&sched->cfg->rss_sources[t.index], &req);
+    else mc_fetch_rest_request(&sched->cfg->rest_sources[t.index], &req);
+
+    /* Ask for the body only if it changed since the last full response */
+    const source_health_t *h = rss ? &sched->rss_health[t.index]
+                                   : &sched->rest_health[t.index];
+    if (!req.post_body) {
+        char hdr[MC_HTTP_MAX_VALIDATOR + 32];
+        if (h->etag[0]) {
+            snprintf(hdr, sizeof(hdr), "If-None-Match: %s", h->etag);
+            mc_http_add_header(&req, hdr);
         }
+        if (h->last_modified[0]) {
+            snprintf(hdr, sizeof(hdr), "If-Modified-Since: %s", h->last_modified);
+            mc_http_add_header(&req, hdr);
+        }
+    }
+
+    fetch_job_t *job = calloc(1, sizeof(*job));
+    if (job) {
+        job->sched = sched;
+        job->rss = rss;
+        job->timer = t;
+        mc_error_t err = mc_http_submit(sched->http, &req, fetch_done, job);
+        if (err == MC_OK) return;
+
+        /* Counts as a failed fetch, so the source backs off */
+        mc_http_response_t resp = { .err = err };
+        snprintf(resp.error, sizeof(resp.error), "%s", mc_error_str(err));
+        fetch_done(job, &resp);
+        return;
+    }
+
+    /* No job to queue: fail the fetch here so the source is not lost */
+    fetch_job_t failed = { .sched = sched, .rss = rss, .timer = t,
+                           .resp = { .err = MC_ERR_OOM, .error = "out of memory" } };
+    if (rss) parse_rss(sched, &failed, NULL);
+    else parse_rest(sched, &failed, NULL, NULL);
+    finish_job(sched, &failed);
+}
 
-        sched->force_refresh = 0;
-        sleep_interruptible(sched, 5);
+/* Wait until a source on either heap is due and may start. Caller holds
+   timer_mutex. Returns 0 once the scheduler stops. */
+static int fetch_wait_due(mc_scheduler_t *sched)
+{
+    while (sched->running) {
+        int64_t due = INT64_MAX;
+        if (sched->rss_timers.count > 0 &&
+            sched->rss_in_flight < sched->cfg->rss_workers)
+            due = sched->rss_timers.items[0].due_ms;
+        if (sched->rest_timers.count > 0 && sched->rest_timers.items[0].due_ms < due)
+            due = sched->rest_timers.items[0].due_ms;
+
+        if (due == INT64_MAX)
+            pthread_cond_wait(&sched->timer_cond, &sched->timer_mutex);
+        else if (due > mono_ms())
+            timer_wait(sched, due);
+        else
+            return 1;
     }
+    return 0;
+}
+
+/* Hands every due source to the HTTP engine. Nothing here waits on the
+   network, so one thread keeps any number of fetches in flight. */
+static void *dispatch_thread_func(void *arg)
+{
+    mc_scheduler_t *sched = arg;
+    struct { int rss; source_timer_t t; } due[2 * MC_MAX_SOURCES];
+
+    pthread_mutex_lock(&sched->timer_mutex);
+    while (fetch_wait_due(sched)) {
+        int64_t now = mono_ms();
+        int n = 0;
+        while (sched->rss_timers.count > 0 && sched->rss_timers.items[0].due_ms <= now &&
+               sched->rss_in_flight < sched->cfg->rss_workers) {
+            due[n].rss = 1;
+            due[n++].t = timer_claim(&sched->rss_timers, sched->rss_health);
+            sched->rss_in_flight++;
+        }
+        while (sched->rest_timers.count > 0 && sched->rest_timers.items[0].due_ms <= now) {
+            due[n].rss = 0;
+            due[n++].t = timer_claim(&sched->rest_timers, sched->rest_health);
+        }
+        pthread_mutex_unlock(&sched->timer_mutex);
 
-    /* Wake workers so they can exit */
-    pthread_mutex_lock(&sched->rest_queue.mutex);
-    pthread_cond_broadcast(&sched->rest_queue.ready);
-    pthread_mutex_unlock(&sched->rest_queue.mutex);
+        for (int i = 0; i < n; i++)
+            submit_fetch(sched, due[i].rss, due[i].t);
 
+        pthread_mutex_lock(&sched->timer_mutex);
+    }
+    pthread_mutex_unlock(&sched->timer_mutex);
     return NULL;
 }
 
-/* Background thread: prune old data + update snapshot periodically */
 static void *prune_thread_func(void *arg)
 {
     mc_scheduler_t *sched = arg;
 
-    while (sched->running) {
-        sleep_interruptible(sched, PRUNE_INTERVAL_SEC);
-        if (!sched->running) break;
-
+    while (sched_sleep(sched, PRUNE_INTERVAL_SEC * 1000)) {
         mc_error_t err = mc_db_prune_old(sched->db, PRUNE_MAX_AGE_SEC);
         if (err == MC_OK)
             MC_LOG_INFO("DB pruned (entries older than %d hours removed)",
                         PRUNE_MAX_AGE_SEC / 3600);
 
-        update_snapshot(sched);
+        request_snapshot(sched);
+    }
+    return NULL;
+}
+
+/* Background thread: WAL checkpoints, optimize and incremental vacuum, so
+   none of it lands on the writer thread's commits */
+static void *maint_thread_func(void *arg)
+{
+    mc_scheduler_t *sched = arg;
+    time_t last_run[MAINT_TASK_COUNT];
+    time_t start = time(NULL);
+    for (int i = 0; i < MAINT_TASK_COUNT; i++)
+        last_run[i] = start;
+
+    for (;;) {
+        time_t next = last_run[0] + MAINT_SCHEDULE[0].interval_sec;
+        for (int i = 1; i < MAINT_TASK_COUNT; i++)
+            if (last_run[i] + MAINT_SCHEDULE[i].interval_sec < next)
+                next = last_run[i] + MAINT_SCHEDULE[i].interval_sec;
+        time_t wait = next - time(NULL);
+        if (!sched_sleep(sched, wait > 0 ? (int64_t)wait * 1000 : 0))
+            break;
+
+        time_t now = time(NULL);
+        for (int i = 0; i < MAINT_TASK_COUNT && sched->running; i++) {
+            if (now - last_run[i] < MAINT_SCHEDULE[i].interval_sec) continue;
+            mc_db_maintain(sched->db, MAINT_SCHEDULE[i].task);
+            last_run[i] = now;
+        }
     }
     return NULL;
 }
@@ -416,63 +891,124 @@ mc_scheduler_t *mc_scheduler_create(const mc_config_t *cfg, mc_db_t *db)
 
     sched->cfg = cfg;
     sched->db = db;
+    snprintf(sched->snapshot_path, sizeof(sched->snapshot_path),
+             "%s.snapshot", cfg->db_path);
+    sched->news = calloc(MAX_SNAPSHOT_NEWS, sizeof(mc_news_rec_t));
+    if (!sched->news) {
+        free(sched);
+        return NULL;
+    }
     pthread_rwlock_init(&sched->snapshot_lock, NULL);
-    pthread_mutex_init(&sched->rest_queue.mutex, NULL);
-    pthread_cond_init(&sched->rest_queue.ready, NULL);
-    pthread_mutex_init(&sched->rest_done_mutex, NULL);
-    pthread_cond_init(&sched->rest_done_cond, NULL);
-    pthread_mutex_init(&sched->snapshot_throttle_mutex, NULL);
+    pthread_mutex_init(&sched->snapshot_req_mutex, NULL);
+    pthread_cond_init(&sched->snapshot_req_cond, NULL);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&sched->timer_mutex, NULL);
+    pthread_mutex_init(&sched->parse_mutex, NULL);
+    pthread_cond_init(&sched->parse_cond, NULL);
+    pthread_cond_init(&sched->timer_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    sched->rss_first_pass_ms = -1;
+
+    /* Every source is due at start */
+    int64_t now = mono_ms();
+    for (int i = 0; i < cfg->rss_count; i++) {
+        sched->rss_health[i].interval_sec = cfg->rss_sources[i].refresh_interval_sec;
+        heap_push(&sched->rss_timers, now, i);
+    }
+    for (int i = 0; i < cfg->rest_count; i++) {
+        sched->rest_health[i].interval_sec = cfg->rest_sources[i].refresh_interval_sec;
+        heap_push(&sched->rest_timers, now, i);
+    }
     return sched;
 }
 
-/* Callback from WS threads when new data arrives */
-static void ws_data_callback(void *userdata)
-{
-    mc_scheduler_t *sched = userdata;
-    update_snapshot(sched); /* global throttle handles debounce */
-}
-
 int mc_scheduler_start(mc_scheduler_t *sched)
 {
     sched->running = 1;
-
-    if (sched->cfg->rss_count > 0) {
-        if (pthread_create(&sched->rss_thread, NULL, rss_thread_func, sched) == 0)
-            sched->rss_thread_active = 1;
-        else
-            MC_LOG_ERROR("Failed to start RSS thread");
+    load_snapshot(sched);
+    sched->last_save_time = time(NULL);
+
+    /* Snapshot rebuilds follow DB commits, not fetch completion, since
+       inserts are applied asynchronously by the DB writer thread */
+    if (pthread_create(&sched->snapshot_thread, NULL,
+                       snapshot_thread_func, sched) == 0)
+        sched->snapshot_thread_active = 1;
+    else
+        MC_LOG_ERROR("Failed to start snapshot thread");
+    mc_db_set_commit_hook(sched->db, db_commit_callback, sched);
+
+    /* Unchanged quotes must still be re-stored before prune would drop
+       their latest row */
+    int heartbeat = sched->cfg->tick_heartbeat_sec;
+    if (heartbeat > PRUNE_MAX_AGE_SEC / 2) {
+        MC_LOG_WARN("tick_heartbeat_sec %d exceeds half the %d s retention, using %d",
+                    heartbeat, PRUNE_MAX_AGE_SEC, PRUNE_MAX_AGE_SEC / 2);
+        heartbeat = PRUNE_MAX_AGE_SEC / 2;
+    }
+    mc_db_set_tick_heartbeat(sched->db, heartbeat);
+
+    /* Likewise an adaptive interval may not outgrow the retention */
+    pthread_mutex_lock(&sched->timer_mutex);
+    for (int i = 0; i < sched->cfg->rss_count + sched->cfg->rest_count; i++) {
+        int rss = i < sched->cfg->rss_count;
+        int k = rss ? i : i - sched->cfg->rss_count;
+        const char *name = rss ? sched->cfg->rss_sources[k].name
+                               : sched->cfg->rest_sources[k].name;
+        int min_sec = rss ? sched->cfg->rss_sources[k].refresh_min_sec
+                          : sched->cfg->rest_sources[k].refresh_min_sec;
+        int max_sec = rss ? sched->cfg->rss_sources[k].refresh_max_sec
+                          : sched->cfg->rest_sources[k].refresh_max_sec;
+        source_health_t *h = rss ? &sched->rss_health[k] : &sched->rest_health[k];
+        if (max_sec <= min_sec || adaptive_max(min_sec, max_sec) == max_sec)
+            continue;
+        max_sec = adaptive_max(min_sec, max_sec);
+        MC_LOG_WARN("Source %s: refresh_max_sec exceeds half the %d s retention, using %d",
+                    name, PRUNE_MAX_AGE_SEC, max_sec);
+        if (h->interval_sec > max_sec) h->interval_sec = max_sec;
     }
 
-    if (sched->cfg->rest_count > 0) {
-        /* Start worker pool */
-        int nworkers = REST_WORKER_COUNT;
-        if (nworkers > sched->cfg->rest_count)
-            nworkers = sched->cfg->rest_count;
+    sched->started_ms = mono_ms();
+    sched->rss_first_pending = sched->cfg->rss_count;
+    pthread_mutex_unlock(&sched->timer_mutex);
+
+    if (sched->cfg->rss_count + sched->cfg->rest_count > 0) {
+        sched->http = mc_http_create();
+        if (!sched->http) {
+            MC_LOG_ERROR("HTTP engine unavailable: RSS and REST sources disabled");
+        } else {
+            /* Sources sharing a host share its budget, force refresh included */
+            const mc_config_t *cfg = sched->cfg;
+            mc_http_set_rate_limit(sched->http, NULL, cfg->host_rate_per_sec,
+                                   cfg->host_burst);
+            for (int i = 0; i < cfg->rate_limit_count; i++)
+                mc_http_set_rate_limit(sched->http, cfg->rate_limits[i].host,
+                                       cfg->rate_limits[i].per_sec,
+                                       cfg->rate_limits[i].burst);
+
+            for (int i = 0; i < PARSE_WORKER_COUNT; i++) {
+                if (pthread_create(&sched->parse_workers[i], NULL,
+                                   parse_worker_func, sched) == 0)
+                    sched->parse_worker_count++;
+                else
+                    MC_LOG_ERROR("Failed to start parse worker %d", i);
+            }
 
-        for (int i = 0; i < nworkers; i++) {
-            if (pthread_create(&sched->rest_workers[i], NULL,
-                               rest_worker_func, sched) == 0)
-                sched->rest_worker_count++;
+            if (pthread_create(&sched->dispatch_thread, NULL,
+                               dispatch_thread_func, sched) == 0)
+                sched->dispatch_thread_active = 1;
             else
-                MC_LOG_ERROR("Failed to start REST worker %d", i);
+                MC_LOG_ERROR("Failed to start fetch dispatcher");
         }
-
-        /* Start dispatcher */
-        if (pthread_create(&sched->rest_dispatch_thread, NULL,
-                           rest_dispatch_func, sched) == 0)
-            sched->rest_dispatch_active = 1;
-        else
-            MC_LOG_ERROR("Failed to start REST dispatcher");
-
-        MC_LOG_INFO("REST pool: %d workers for %d sources",
-                    sched->rest_worker_count, sched->cfg->rest_count);
     }
 
     /* Start WebSocket connections */
     for (int i = 0; i < sched->cfg->ws_count; i++) {
         mc_ws_conn_t *conn = mc_ws_connect(
-            &sched->cfg->ws_sources[i], sched->db,
-            ws_data_callback, sched);
+            &sched->cfg->ws_sources[i], sched->db, NULL, NULL);
         if (conn) {
             sched->ws_conns[sched->ws_count] = conn;
             sched->ws_count++;
@@ -483,35 +1019,59 @@ int mc_scheduler_start(mc_scheduler_t *sched)
     if (pthread_create(&sched->prune_thread, NULL, prune_thread_func, sched) == 0)
         sched->prune_thread_active = 1;
 
-    MC_LOG_INFO("Scheduler started: %d RSS, %d REST (%d workers), %d WS + pruning",
-                sched->cfg->rss_count, sched->cfg->rest_count,
-                sched->rest_worker_count, sched->ws_count);
+    if (pthread_create(&sched->maint_thread, NULL, maint_thread_func, sched) == 0)
+        sched->maint_thread_active = 1;
+    else
+        MC_LOG_ERROR("Failed to start DB maintenance thread");
+
+    MC_LOG_INFO("Scheduler started: %d RSS (%d in flight), %d REST, %d WS "
+                "(%d parse workers) + pruning, maintenance",
+                sched->cfg->rss_count, sched->cfg->rss_workers, sched->cfg->rest_count,
+                sched->ws_count, sched->parse_worker_count);
     return 0;
 }
 
 void mc_scheduler_stop(mc_scheduler_t *sched)
 {
     if (!sched) return;
-    sched->running = 0;
+    mc_db_set_commit_hook(sched->db, NULL, NULL);
 
-    /* Wake workers waiting on queue */
-    pthread_mutex_lock(&sched->rest_queue.mutex);
-    pthread_cond_broadcast(&sched->rest_queue.ready);
-    pthread_mutex_unlock(&sched->rest_queue.mutex);
-
-    /* Wake dispatcher waiting on batch done */
-    pthread_mutex_lock(&sched->rest_done_mutex);
-    pthread_cond_signal(&sched->rest_done_cond);
-    pthread_mutex_unlock(&sched->rest_done_mutex);
-
-    if (sched->rss_thread_active)
-        pthread_join(sched->rss_thread, NULL);
-    if (sched->rest_dispatch_active)
-        pthread_join(sched->rest_dispatch_thread, NULL);
-    for (int i = 0; i < sched->rest_worker_count; i++)
-        pthread_join(sched->rest_workers[i], NULL);
+    /* Wake every loop sleeping on a deadline */
+    pthread_mutex_lock(&sched->timer_mutex);
+    sched->running = 0;
+    pthread_cond_broadcast(&sched->timer_cond);
+    pthread_mutex_unlock(&sched->timer_mutex);
+
+    pthread_mutex_lock(&sched->parse_mutex);
+    pthread_cond_broadcast(&sched->parse_cond);
+    pthread_mutex_unlock(&sched->parse_mutex);
+
+    if (sched->dispatch_thread_active)
+        pthread_join(sched->dispatch_thread, NULL);
+    for (int i = 0; i < sched->parse_worker_count; i++)
+        pthread_join(sched->parse_workers[i], NULL);
+
+    /* Transfers still in flight come back aborted; drop them unparsed */
+    mc_http_destroy(sched->http);
+    sched->http = NULL;
+    while (sched->parse_head) {
+        fetch_job_t *job = sched->parse_head;
+        sched->parse_head = job->next;
+        free(job->resp.body);
+        free(job);
+    }
+    sched->parse_tail = NULL;
     if (sched->prune_thread_active)
         pthread_join(sched->prune_thread, NULL);
+    if (sched->maint_thread_active)
+        pthread_join(sched->maint_thread, NULL);
+
+    pthread_mutex_lock(&sched->snapshot_req_mutex);
+    pthread_cond_signal(&sched->snapshot_req_cond);
+    pthread_mutex_unlock(&sched->snapshot_req_mutex);
+    if (sched->snapshot_thread_active)
+        pthread_join(sched->snapshot_thread, NULL);
+    save_snapshot(sched);
 
     for (int i = 0; i < sched->ws_count; i++)
         mc_ws_disconnect(sched->ws_conns[i]);
@@ -523,35 +1083,115 @@ void mc_scheduler_destroy(mc_scheduler_t *sched)
 {
     if (!sched) return;
     pthread_rwlock_destroy(&sched->snapshot_lock);
-    pthread_mutex_destroy(&sched->rest_queue.mutex);
-    pthread_cond_destroy(&sched->rest_queue.ready);
-    pthread_mutex_destroy(&sched->rest_done_mutex);
-    pthread_cond_destroy(&sched->rest_done_cond);
-    pthread_mutex_destroy(&sched->snapshot_throttle_mutex);
+    pthread_mutex_destroy(&sched->snapshot_req_mutex);
+    pthread_cond_destroy(&sched->snapshot_req_cond);
+    pthread_mutex_destroy(&sched->timer_mutex);
+    pthread_mutex_destroy(&sched->parse_mutex);
+    pthread_cond_destroy(&sched->parse_cond);
+    pthread_cond_destroy(&sched->timer_cond);
+    mc_news_rec_free(sched->news, sched->news_count);
+    free(sched->news);
     free(sched);
 }
 
+/* Make every source due now, backoff included. Sources being fetched are
+   not in a heap and keep their next deadline. */
 void mc_scheduler_force_refresh(mc_scheduler_t *sched)
 {
-    if (sched) sched->force_refresh = 1;
+    if (!sched) return;
+    int64_t now = mono_ms();
+    timer_heap_t *heaps[2] = { &sched->rss_timers, &sched->rest_timers };
+
+    pthread_mutex_lock(&sched->timer_mutex);
+    for (int k = 0; k < 2; k++)
+        for (int i = 0; i < heaps[k]->count; i++)
+            heaps[k]->items[i].due_ms = now;  /* All equal: still a heap */
+    pthread_cond_broadcast(&sched->timer_cond);
+    pthread_mutex_unlock(&sched->timer_mutex);
 }
 
 int mc_scheduler_get_entries(mc_scheduler_t *sched,
-                             mc_data_entry_t *out, int max_count)
+                             mc_entry_rec_t *out, int max_count)
 {
     pthread_rwlock_rdlock(&sched->snapshot_lock);
     int n = sched->entry_count < max_count ? sched->entry_count : max_count;
-    memcpy(out, sched->entries, n * sizeof(mc_data_entry_t));
+    memcpy(out, sched->entries, n * sizeof(mc_entry_rec_t));
     pthread_rwlock_unlock(&sched->snapshot_lock);
     return n;
 }
 
 int mc_scheduler_get_news(mc_scheduler_t *sched,
-                          mc_news_item_t *out, int max_count)
+                          mc_news_item_t *out, int max_count, int with_summary)
 {
     pthread_rwlock_rdlock(&sched->snapshot_lock);
     int n = sched->news_count < max_count ? sched->news_count : max_count;
-    memcpy(out, sched->news, n * sizeof(mc_news_item_t));
+    for (int i = 0; i < n; i++)
+        mc_news_rec_unpack(&sched->news[i], &out[i], with_summary);
+    pthread_rwlock_unlock(&sched->snapshot_lock);
+    return n;
+}
+
+time_t mc_scheduler_snapshot_time(mc_scheduler_t *sched, int *warm)
+{
+    pthread_rwlock_rdlock(&sched->snapshot_lock);
+    time_t built_at = sched->snapshot_built_at;
+    if (warm) *warm = sched->snapshot_warm;
     pthread_rwlock_unlock(&sched->snapshot_lock);
+    return built_at;
+}
+
+static int add_delay_stats(mc_sched_source_stats_t *out, int n, int max_count,
+                           const char *name, mc_source_type_t type,
+                           const source_health_t *h)
+{
+    if (n >= max_count || h->fetches == 0) return n;
+    mc_sched_source_stats_t *o = &out[n];
+    snprintf(o->source_name, sizeof(o->source_name), "%s", name);
+    o->source_type = type;
+    o->fetches = h->fetches;
+    o->delay_last_ms = h->delay_last_ms;
+    o->delay_avg_ms = (double)h->delay_total_ms / (double)h->fetches;
+    o->delay_max_ms = h->delay_max_ms;
+    o->not_modified = h->not_modified;
+    o->bytes_saved = h->bytes_saved;
+    o->bytes_wire = h->bytes_wire;
+    o->bytes_decoded = h->bytes_decoded;
+    o->interval_sec = h->interval_sec;
+    o->changes = h->changes;
+    o->rate_limited = h->rate_limited;
+    int64_t wait = h->rate_limited_until_ms - mono_ms();
+    o->retry_in_sec = wait > 0 ? (int)((wait + 999) / 1000) : 0;
+    return n + 1;
+}
+
+int mc_scheduler_get_source_stats(mc_scheduler_t *sched,
+                                  mc_sched_source_stats_t *out, int max_count)
+{
+    int n = 0;
+    pthread_mutex_lock(&sched->timer_mutex);
+    for (int i = 0; i < sched->cfg->rss_count; i++)
+        n = add_delay_stats(out, n, max_count, sched->cfg->rss_sources[i].name,
+                            MC_SOURCE_RSS, &sched->rss_health[i]);
+    for (int i = 0; i < sched->cfg->rest_count; i++)
+        n = add_delay_stats(out, n, max_count, sched->cfg->rest_sources[i].name,
+                            MC_SOURCE_REST, &sched->rest_health[i]);
+    pthread_mutex_unlock(&sched->timer_mutex);
     return n;
 }
+
+double mc_scheduler_rss_first_pass(mc_scheduler_t *sched)
+{
+    pthread_mutex_lock(&sched->timer_mutex);
+    int64_t ms = sched->rss_first_pass_ms;
+    pthread_mutex_unlock(&sched->timer_mutex);
+    return ms < 0 ? -1.0 : (double)ms / 1000.0;
+}
+
+int mc_scheduler_get_http_stats(mc_scheduler_t *sched, int *in_flight,
+                                mc_http_host_stats_t *out, int max_count)
+{
+    *in_flight = 0;
+    if (!sched->http) return 0;
+    *in_flight = mc_http_in_flight(sched->http);
+    return mc_http_get_host_stats(sched->http, out, max_count);
+}
@@ -0,0 +1,350 @@
+#include "mc_snapshot.h"
+#include "mc_log.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#define SNAP_MAGIC    0x4e53434du  /* "MCSN" */
+#define SNAP_VERSION  1
+
+/* Layout: header, then the payload the CRC covers:
+     strings  string_count x { u32 id, u16 len, bytes }
+     entries  entry_count x snap_entry_t
+     news     news_count x { snap_news_t, title, source, url, region,
+                             country as u16 len + bytes, packed summary } */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t string_count;
+    uint32_t id_limit;       /* One past the highest stored id */
+    uint32_t entry_count;
+    uint32_t news_count;
+    int64_t  built_at;
+    uint64_t payload_size;
+    uint32_t crc;
+    uint32_t reserved;
+} snap_header_t;
+
+typedef struct {
+    int64_t  id;
+    uint32_t source_id;
+    uint32_t symbol_id;
+    uint32_t display_id;
+    uint32_t currency_id;
+    int32_t  source_type;
+    int32_t  category;
+    double   value;
+    double   change_pct;
+    double   volume;
+    int64_t  timestamp;
+    int64_t  fetched_at;
+} snap_entry_t;
+
+typedef struct {
+    int64_t  id;
+    int64_t  published_at;
+    int64_t  fetched_at;
+    double   score;
+    int32_t  category;
+    uint32_t summary_len;
+} snap_news_t;
+
+typedef struct {
+    unsigned char *data;
+    size_t         len;
+    size_t         cap;
+    int            failed;
+} buf_t;
+
+static void buf_put(buf_t *b, const void *p, size_t n)
+{
+    if (b->failed) return;
+    if (b->len + n > b->cap) {
+        size_t cap = b->cap ? b->cap : 65536;
+        while (cap < b->len + n) cap *= 2;
+        unsigned char *data = realloc(b->data, cap);
+        if (!data) {
+            b->failed = 1;
+            return;
+        }
+        b->data = data;
+        b->cap = cap;
+    }
+    memcpy(b->data + b->len, p, n);
+    b->len += n;
+}
+
+static void buf_put_str(buf_t *b, const char *s)
+{
+    uint16_t len = (uint16_t)strnlen(s, UINT16_MAX);
+    buf_put(b, &len, sizeof(len));
+    buf_put(b, s, len);
+}
+
+typedef struct {
+    const unsigned char *p;
+    const unsigned char *end;
+} cursor_t;
+
+static int cur_get(cursor_t *c, void *out, size_t n)
+{
+    if ((size_t)(c->end - c->p) < n) return -1;
+    memcpy(out, c->p, n);
+    c->p += n;
+    return 0;
+}
+
+/* Fails if the string does not fit in cap with its terminator */
+static int cur_get_str(cursor_t *c, char *out, size_t cap)
+{
+    uint16_t len;
+    if (cur_get(c, &len, sizeof(len)) != 0 || len >= cap) return -1;
+    if (cur_get(c, out, len) != 0) return -1;
+    out[len] = '\0';
+    return 0;
+}
+
+static int write_all(int fd, const void *data, size_t size)
+{
+    const unsigned char *p = data;
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        size -= (size_t)n;
+    }
+    return 0;
+}
+
+mc_error_t mc_snapshot_save(const char *path, time_t built_at,
+                            const mc_entry_rec_t *entries, int entry_count,
+                            const mc_news_rec_t *news, int news_count)
+{
+    /* Only the strings these entries reference go into the file */
+    uint32_t limit = mc_intern_count();
+    unsigned char *used = calloc(limit ? limit : 1, 1);
+    if (!used) return MC_ERR_OOM;
+    for (int i = 0; i < entry_count; i++) {
+        const mc_entry_rec_t *e = &entries[i];
+        uint32_t ids[4] = { e->source_id, e->symbol_id, e->display_id, e->currency_id };
+        for (int k = 0; k < 4; k++)
+            if (ids[k] < limit) used[ids[k]] = 1;
+    }
+
+    buf_t b = {0};
+    uint32_t string_count = 0;
+    for (uint32_t id = 1; id < limit; id++) {
+        if (!used[id]) continue;
+        buf_put(&b, &id, sizeof(id));
+        buf_put_str(&b, mc_intern_str(id));
+        string_count++;
+    }
+    free(used);
+
+    for (int i = 0; i < entry_count; i++) {
+        const mc_entry_rec_t *e = &entries[i];
+        snap_entry_t r = {
+            .id = e->id,
+            .source_id = e->source_id,
+            .symbol_id = e->symbol_id,
+            .display_id = e->display_id,
+            .currency_id = e->currency_id,
+            .source_type = e->source_type,
+            .category = e->category,
+            .value = e->value,
+            .change_pct = e->change_pct,
+            .volume = e->volume,
+            .timestamp = e->timestamp,
+            .fetched_at = e->fetched_at,
+        };
+        buf_put(&b, &r, sizeof(r));
+    }
+
+    for (int i = 0; i < news_count; i++) {
+        const mc_news_rec_t *n = &news[i];
+        snap_news_t r = {
+            .id = n->id,
+            .published_at = n->published_at,
+            .fetched_at = n->fetched_at,
+            .score = n->score,
+            .category = n->category,
+            .summary_len = n->summary ? n->summary_len : 0,
+        };
+        buf_put(&b, &r, sizeof(r));
+        buf_put_str(&b, n->title);
+        buf_put_str(&b, n->source);
+        buf_put_str(&b, n->url);
+        buf_put_str(&b, n->region);
+        buf_put_str(&b, n->country);
+        if (r.summary_len) buf_put(&b, n->summary, r.summary_len);
+    }
+
+    if (b.failed) {
+        free(b.data);
+        return MC_ERR_OOM;
+    }
+
+    snap_header_t hdr = {
+        .magic = SNAP_MAGIC,
+        .version = SNAP_VERSION,
+        .string_count = string_count,
+        .id_limit = limit,
+        .entry_count = (uint32_t)entry_count,
+        .news_count = (uint32_t)news_count,
+        .built_at = built_at,
+        .payload_size = b.len,
+        .crc = (uint32_t)crc32(0L, b.data, (uInt)b.len),
+    };
+
+    /* No fsync: a file lost or torn in a crash only costs a cold start */
+    char tmp[1024];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    mc_error_t err = MC_OK;
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 ||
+        write_all(fd, &hdr, sizeof(hdr)) != 0 ||
+        write_all(fd, b.data, b.len) != 0) {
+        MC_LOG_WARN("Snapshot %s: %s", tmp, strerror(errno));
+        err = MC_ERR_IO;
+    }
+    if (fd >= 0) close(fd);
+    free(b.data);
+
+    if (err == MC_OK && rename(tmp, path) != 0) {
+        MC_LOG_WARN("Snapshot %s: %s", path, strerror(errno));
+        err = MC_ERR_IO;
+    }
+    if (err != MC_OK) unlink(tmp);
+    return err;
+}
+
+static int parse(const snap_header_t *hdr, cursor_t *c,
+                 mc_entry_rec_t *entries, int *entry_count, int max_entries,
+                 mc_news_rec_t *news, int *news_count, int max_news)
+{
+    /* Ids in the file are remapped onto this process's dictionary */
+    uint32_t *remap = calloc(hdr->id_limit ? hdr->id_limit : 1, sizeof(uint32_t));
+    if (!remap) return -1;
+
+    char str[MC_MAX_URL];
+    for (uint32_t i = 0; i < hdr->string_count; i++) {
+        uint32_t id;
+        if (cur_get(c, &id, sizeof(id)) != 0 || id >= hdr->id_limit ||
+            cur_get_str(c, str, sizeof(str)) != 0) {
+            free(remap);
+            return -1;
+        }
+        remap[id] = mc_intern(str);
+    }
+
+    for (uint32_t i = 0; i < hdr->entry_count; i++) {
+        snap_entry_t r;
+        if (cur_get(c, &r, sizeof(r)) != 0 ||
+            r.source_id >= hdr->id_limit || r.symbol_id >= hdr->id_limit ||
+            r.display_id >= hdr->id_limit || r.currency_id >= hdr->id_limit) {
+            free(remap);
+            return -1;
+        }
+        if (*entry_count >= max_entries) continue;
+        mc_entry_rec_t *e = &entries[(*entry_count)++];
+        e->id = r.id;
+        e->source_id = remap[r.source_id];
+        e->symbol_id = remap[r.symbol_id];
+        e->display_id = remap[r.display_id];
+        e->currency_id = remap[r.currency_id];
+        e->source_type = (mc_source_type_t)r.source_type;
+        e->category = (mc_category_t)r.category;
+        e->value = r.value;
+        e->change_pct = r.change_pct;
+        e->volume = r.volume;
+        e->timestamp = (time_t)r.timestamp;
+        e->fetched_at = (time_t)r.fetched_at;
+    }
+    free(remap);
+
+    for (uint32_t i = 0; i < hdr->news_count && *news_count < max_news; i++) {
+        snap_news_t r;
+        mc_news_rec_t *n = &news[*news_count];
+        memset(n, 0, sizeof(*n));
+        if (cur_get(c, &r, sizeof(r)) != 0 ||
+            cur_get_str(c, n->title, sizeof(n->title)) != 0 ||
+            cur_get_str(c, n->source, sizeof(n->source)) != 0 ||
+            cur_get_str(c, n->url, sizeof(n->url)) != 0 ||
+            cur_get_str(c, n->region, sizeof(n->region)) != 0 ||
+            cur_get_str(c, n->country, sizeof(n->country)) != 0 ||
+            r.summary_len > MC_SUMMARY_PACK_MAX)
+            return -1;
+        n->id = r.id;
+        n->published_at = (time_t)r.published_at;
+        n->fetched_at = (time_t)r.fetched_at;
+        n->score = r.score;
+        n->category = (mc_category_t)r.category;
+        if (r.summary_len) {
+            n->summary = malloc(r.summary_len);
+            if (!n->summary || cur_get(c, n->summary, r.summary_len) != 0) {
+                free(n->summary);
+                n->summary = NULL;
+                return -1;
+            }
+            n->summary_len = r.summary_len;
+        }
+        (*news_count)++;
+    }
+    return 0;
+}
+
+mc_error_t mc_snapshot_load(const char *path, time_t *built_at,
+                            mc_entry_rec_t *entries, int *entry_count, int max_entries,
+                            mc_news_rec_t *news, int *news_count, int max_news)
+{
+    *entry_count = 0;
+    *news_count = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return errno == ENOENT ? MC_ERR_NOT_FOUND : MC_ERR_IO;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(snap_header_t)) {
+        close(fd);
+        return MC_ERR_PARSE;
+    }
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return MC_ERR_IO;
+
+    snap_header_t hdr;
+    memcpy(&hdr, map, sizeof(hdr));
+    const unsigned char *payload = (const unsigned char *)map + sizeof(hdr);
+
+    mc_error_t err = MC_OK;
+    if (hdr.magic != SNAP_MAGIC || hdr.version != SNAP_VERSION ||
+        hdr.payload_size != size - sizeof(hdr) ||
+        hdr.crc != (uint32_t)crc32(0L, payload, (uInt)hdr.payload_size)) {
+        err = MC_ERR_PARSE;
+    } else {
+        cursor_t c = { payload, payload + hdr.payload_size };
+        if (parse(&hdr, &c, entries, entry_count, max_entries,
+                  news, news_count, max_news) != 0) {
+            mc_news_rec_free(news, *news_count);
+            *entry_count = 0;
+            *news_count = 0;
+            err = MC_ERR_PARSE;
+        }
+    }
+    munmap(map, size);
+
+    if (err == MC_OK) *built_at = (time_t)hdr.built_at;
+    return err;
+}
@@ -0,0 +1,134 @@
+#include "mc_summary.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#define SUMMARY_RAW      0   /* Text follows as is */
+#define SUMMARY_DEFLATE  1   /* Raw deflate, SUMMARY_DICT preset */
+#define SUMMARY_WBITS    13  /* 8 KB window: dictionary plus longest summary */
+
+/* Preset dictionary: phrasing common to RSS summaries and calendar
+   events. Deflate prefers recent bytes, so the most frequent go last.
+   Changing it breaks every stored summary; add a new format instead. */
+static const char SUMMARY_DICT[] =
+    "Die Europaische Zentralbank hat die Zinsen unverandert gelassen. "
+    "La Banque centrale europeenne a annonce que les taux d'interet restent inchanges. "
+    "Le gouvernement a annonce des mesures pour soutenir l'economie. "
+    "press release speech testimony statement monetary policy financial stability report. "
+    "This article was originally published on. Read more. Continue reading. "
+    "Click here to read the full story. The post appeared first on. "
+    "Chief executive officer, chief financial officer, said in an interview. "
+    "The deal is expected to close in the second half of the year, subject to regulatory approval. "
+    "The minister told reporters on Monday, Tuesday, Wednesday, Thursday, Friday that the government would. "
+    "Gross domestic product grew at an annual rate in the first quarter, second quarter, third quarter, fourth quarter. "
+    "Economists polled by Reuters had expected. "
+    "Consumer prices rose compared with a year earlier, the Bureau of Labor Statistics said. "
+    "The Department of Labor reported that nonfarm payrolls increased and the unemployment rate was unchanged. "
+    "The government announced new tariffs on imports from China. "
+    "The S&P 500, the Nasdaq Composite and the Dow Jones Industrial Average. Stocks in Europe and Asia. "
+    "Bitcoin and other cryptocurrencies traded higher. Gold prices hit a record high. "
+    "Oil prices dropped as crude inventories increased more than expected. "
+    "Treasury yields climbed and the dollar strengthened against major currencies. "
+    "The Federal Reserve, the European Central Bank, the Bank of England and the Bank of Japan. "
+    "Policymakers said the outlook remains uncertain. "
+    "The central bank left interest rates unchanged and signaled that it would continue to monitor inflation. "
+    "Shares fell in early trading on Wall Street as investors weighed the latest economic data. "
+    "Shares rose in premarket trading after the announcement. "
+    "The company said in a statement that it expects revenue and earnings for the fiscal year "
+    "to be in line with analysts' estimates, according to people familiar with the matter. "
+    "billion dollars, million dollars, per cent, percent, basis points, "
+    "year-on-year, month-on-month, quarter-on-quarter. "
+    "Impact: Low | Impact: Medium | Impact: High | Forecast: | Previous: | Actual: ";
+
+size_t mc_summary_pack(const char *text, unsigned char *out, size_t cap)
+{
+    size_t len = text ? strlen(text) : 0;
+    if (len == 0 || cap < 2) return 0;
+
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, -SUMMARY_WBITS,
+                     8, Z_DEFAULT_STRATEGY) == Z_OK) {
+        deflateSetDictionary(&zs, (const Bytef *)SUMMARY_DICT, sizeof(SUMMARY_DICT) - 1);
+        zs.next_in = (Bytef *)text;
+        zs.avail_in = (uInt)len;
+        zs.next_out = out + 1;
+        zs.avail_out = (uInt)(cap - 1 < len ? cap - 1 : len);  /* Must beat raw */
+        int rc = deflate(&zs, Z_FINISH);
+        size_t zlen = zs.total_out;
+        deflateEnd(&zs);
+        if (rc == Z_STREAM_END) {
+            out[0] = SUMMARY_DEFLATE;
+            return zlen + 1;
+        }
+    }
+
+    if (len > cap - 1) len = cap - 1;
+    out[0] = SUMMARY_RAW;
+    memcpy(out + 1, text, len);
+    return len + 1;
+}
+
+int mc_summary_unpack(const void *packed, size_t len, char *out, size_t cap)
+{
+    const unsigned char *p = packed;
+    if (cap == 0) return -1;
+    out[0] = '\0';
+    if (!p || len == 0) return 0;
+
+    if (p[0] == SUMMARY_RAW) {
+        size_t n = len - 1 < cap - 1 ? len - 1 : cap - 1;
+        memcpy(out, p + 1, n);
+        out[n] = '\0';
+        return n == len - 1 ? 0 : -1;
+    }
+    if (p[0] != SUMMARY_DEFLATE) return -1;
+
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (inflateInit2(&zs, -SUMMARY_WBITS) != Z_OK) return -1;
+    inflateSetDictionary(&zs, (const Bytef *)SUMMARY_DICT, sizeof(SUMMARY_DICT) - 1);
+    zs.next_in = (Bytef *)(p + 1);
+    zs.avail_in = (uInt)(len - 1);
+    zs.next_out = (Bytef *)out;
+    zs.avail_out = (uInt)(cap - 1);
+    int rc = inflate(&zs, Z_FINISH);
+    size_t n = zs.total_out;
+    inflateEnd(&zs);
+
+    if (rc != Z_STREAM_END) {
+        out[0] = '\0';
+        return -1;
+    }
+    out[n] = '\0';
+    return 0;
+}
+
+void mc_news_rec_unpack(const mc_news_rec_t *r, mc_news_item_t *out,
+                        int with_summary)
+{
+    out->id = r->id;
+    memcpy(out->title, r->title, sizeof(out->title));
+    memcpy(out->source, r->source, sizeof(out->source));
+    memcpy(out->url, r->url, sizeof(out->url));
+    out->category = r->category;
+    out->published_at = r->published_at;
+    out->fetched_at = r->fetched_at;
+    out->score = r->score;
+    memcpy(out->region, r->region, sizeof(out->region));
+    memcpy(out->country, r->country, sizeof(out->country));
+
+    out->summary[0] = '\0';
+    if (with_summary)
+        mc_summary_unpack(r->summary, r->summary_len, out->summary, MC_MAX_SUMMARY);
+}
+
+void mc_news_rec_free(mc_news_rec_t *recs, int count)
+{
+    for (int i = 0; i < count; i++) {
+        free(recs[i].summary);
+        recs[i].summary = NULL;
+        recs[i].summary_len = 0;
+    }
+}
@@ -0,0 +1,534 @@
+#include "mc_ticks.h"
+#include "mc_log.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TICKS_MAGIC        0x4b54434du  /* "MCTK" */
+#define TICKS_VERSION      2            /* 2: records carry fetched_at */
+#define TICKS_HEADER_SIZE  4096         /* Keeps the records page-aligned */
+#define TICKS_SEG_RECORDS  4096         /* 160 KiB of records per segment */
+#define TICKS_SEG_SPAN_SEC 300          /* Retention granularity */
+
+/* On-disk layout: a header page followed by capacity fixed-width records.
+   Files are created at full size (sparse) and mapped once, so readers'
+   pointers stay valid while the writer appends. */
+typedef struct {
+    int64_t timestamp;
+    int64_t fetched_at;
+    double  value;
+    double  change_pct;
+    double  volume;
+} tick_rec_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t capacity;
+    int64_t  first_ts;
+    int64_t  last_ts;
+    int32_t  source_type;
+    int32_t  category;
+    char     source_name[MC_MAX_SOURCE];
+    char     symbol[MC_MAX_SYMBOL];
+    char     display_name[MC_MAX_NAME];
+    char     currency[MC_MAX_SYMBOL];
+} seg_header_t;
+
+typedef struct {
+    uint32_t      seq;   /* File name: <seq>.seg */
+    seg_header_t *hdr;   /* Start of the mapping */
+    tick_rec_t   *recs;
+} segment_t;
+
+typedef struct {
+    char       source_name[MC_MAX_SOURCE];
+    char       symbol[MC_MAX_SYMBOL];
+    char      *dir;
+    segment_t *segs;     /* Oldest first */
+    int        seg_count;
+    int        seg_cap;
+    uint32_t   next_seq;
+} series_t;
+
+struct mc_ticks {
+    char             *dir;
+    pthread_rwlock_t  lock;   /* Writer for append/prune, readers for history */
+
+    series_t        **series;
+    int               series_count;
+    int               series_cap;
+
+    /* Open-addressing index on (source, symbol): series index + 1, 0 = empty */
+    int              *index;
+    int               index_cap;  /* Power of two */
+};
+
+static size_t segment_bytes(uint32_t capacity)
+{
+    return TICKS_HEADER_SIZE + (size_t)capacity * sizeof(tick_rec_t);
+}
+
+static uint32_t series_hash(const char *source, const char *symbol)
+{
+    uint32_t h = 2166136261u;
+    for (const char *p = source; *p; p++) h = (h ^ (uint8_t)*p) * 16777619u;
+    h = (h ^ 0xffu) * 16777619u;
+    for (const char *p = symbol; *p; p++) h = (h ^ (uint8_t)*p) * 16777619u;
+    return h;
+}
+
+/* Filesystem-safe name component: [A-Za-z0-9._-] kept, rest as %XX */
+static void escape_name(const char *in, char *out, size_t out_size)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    size_t n = 0;
+    for (const unsigned char *p = (const unsigned char *)in; *p && n + 4 < out_size; p++) {
+        if ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') ||
+            (*p >= '0' && *p <= '9') || *p == '.' || *p == '_' || *p == '-') {
+            out[n++] = (char)*p;
+        } else {
+            out[n++] = '%';
+            out[n++] = hex[*p >> 4];
+            out[n++] = hex[*p & 15];
+        }
+    }
+    out[n] = '\0';
+}
+
+static int index_grow(mc_ticks_t *ts)
+{
+    int cap = ts->index_cap ? ts->index_cap * 2 : 256;
+    int *idx = calloc((size_t)cap, sizeof(*idx));
+    if (!idx) return -1;
+
+    for (int i = 0; i < ts->series_count; i++) {
+        series_t *s = ts->series[i];
+        uint32_t h = series_hash(s->source_name, s->symbol) & (uint32_t)(cap - 1);
+        while (idx[h]) h = (h + 1) & (uint32_t)(cap - 1);
+        idx[h] = i + 1;
+    }
+    free(ts->index);
+    ts->index = idx;
+    ts->index_cap = cap;
+    return 0;
+}
+
+static series_t *series_find(mc_ticks_t *ts, const char *source, const char *symbol)
+{
+    if (!ts->index_cap) return NULL;
+    uint32_t h = series_hash(source, symbol) & (uint32_t)(ts->index_cap - 1);
+    while (ts->index[h]) {
+        series_t *s = ts->series[ts->index[h] - 1];
+        if (strcmp(s->symbol, symbol) == 0 && strcmp(s->source_name, source) == 0)
+            return s;
+        h = (h + 1) & (uint32_t)(ts->index_cap - 1);
+    }
+    return NULL;
+}
+
+static series_t *series_add(mc_ticks_t *ts, const char *source, const char *symbol,
+                            const char *dir)
+{
+    if ((ts->series_count + 1) * 2 > ts->index_cap && index_grow(ts) != 0)
+        return NULL;
+
+    if (ts->series_count == ts->series_cap) {
+        int cap = ts->series_cap ? ts->series_cap * 2 : 64;
+        series_t **arr = realloc(ts->series, (size_t)cap * sizeof(*arr));
+        if (!arr) return NULL;
+        ts->series = arr;
+        ts->series_cap = cap;
+    }
+
+    series_t *s = calloc(1, sizeof(*s));
+    if (!s) return NULL;
+    strncpy(s->source_name, source, MC_MAX_SOURCE - 1);
+    strncpy(s->symbol, symbol, MC_MAX_SYMBOL - 1);
+    s->dir = strdup(dir);
+    if (!s->dir) {
+        free(s);
+        return NULL;
+    }
+
+    ts->series[ts->series_count++] = s;
+    uint32_t h = series_hash(s->source_name, s->symbol) & (uint32_t)(ts->index_cap - 1);
+    while (ts->index[h]) h = (h + 1) & (uint32_t)(ts->index_cap - 1);
+    ts->index[h] = ts->series_count;
+    return s;
+}
+
+static int series_push_segment(series_t *s, const segment_t *seg)
+{
+    if (s->seg_count == s->seg_cap) {
+        int cap = s->seg_cap ? s->seg_cap * 2 : 8;
+        segment_t *arr = realloc(s->segs, (size_t)cap * sizeof(*arr));
+        if (!arr) return -1;
+        s->segs = arr;
+        s->seg_cap = cap;
+    }
+
+    /* Keep oldest first; loading from readdir() arrives unordered */
+    int i = s->seg_count;
+    while (i > 0 && s->segs[i - 1].seq > seg->seq) {
+        s->segs[i] = s->segs[i - 1];
+        i--;
+    }
+    s->segs[i] = *seg;
+    s->seg_count++;
+    if (seg->seq >= s->next_seq) s->next_seq = seg->seq + 1;
+    return 0;
+}
+
+static void segment_path(const series_t *s, uint32_t seq, char *out, size_t size)
+{
+    snprintf(out, size, "%s/%08u.seg", s->dir, seq);
+}
+
+static void segment_unmap(segment_t *seg)
+{
+    munmap(seg->hdr, segment_bytes(seg->hdr->capacity));
+    seg->hdr = NULL;
+    seg->recs = NULL;
+}
+
+static void *map_file(int fd, size_t size)
+{
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+/* Start a new segment for the series, seeded with the entry's metadata */
+static segment_t *segment_create(series_t *s, const mc_data_entry_t *e)
+{
+    char path[1024];
+    segment_t seg = { .seq = s->next_seq };
+    segment_path(s, seg.seq, path, sizeof(path));
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        MC_LOG_ERROR("Tick segment %s: %s", path, strerror(errno));
+        return NULL;
+    }
+
+    size_t size = segment_bytes(TICKS_SEG_RECORDS);
+    void *base = NULL;
+    if (ftruncate(fd, (off_t)size) == 0)
+        base = map_file(fd, size);
+    close(fd);
+    if (!base) {
+        MC_LOG_ERROR("Tick segment %s: %s", path, strerror(errno));
+        unlink(path);
+        return NULL;
+    }
+
+    seg.hdr = base;
+    seg.recs = (tick_rec_t *)((char *)base + TICKS_HEADER_SIZE);
+    seg.hdr->magic = TICKS_MAGIC;
+    seg.hdr->version = TICKS_VERSION;
+    seg.hdr->capacity = TICKS_SEG_RECORDS;
+    seg.hdr->source_type = e->source_type;
+    seg.hdr->category = e->category;
+    memcpy(seg.hdr->source_name, s->source_name, MC_MAX_SOURCE);
+    memcpy(seg.hdr->symbol, s->symbol, MC_MAX_SYMBOL);
+    strncpy(seg.hdr->display_name, e->display_name, MC_MAX_NAME - 1);
+    strncpy(seg.hdr->currency, e->currency, MC_MAX_SYMBOL - 1);
+
+    if (series_push_segment(s, &seg) != 0) {
+        segment_unmap(&seg);
+        unlink(path);
+        return NULL;
+    }
+    return &s->segs[s->seg_count - 1];
+}
+
+/* Map an existing segment file; returns 0 and fills seg on success,
+   -2 for a segment written in an older format */
+static int segment_load(const char *path, segment_t *seg)
+{
+    int fd = open(path, O_RDWR);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    void *base = NULL;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= TICKS_HEADER_SIZE)
+        base = map_file(fd, (size_t)st.st_size);
+    close(fd);
+    if (!base) return -1;
+
+    seg_header_t *hdr = base;
+    if (hdr->magic == TICKS_MAGIC && hdr->version < TICKS_VERSION) {
+        munmap(base, (size_t)st.st_size);
+        return -2;
+    }
+    if (hdr->magic != TICKS_MAGIC || hdr->version != TICKS_VERSION ||
+        (size_t)st.st_size != segment_bytes(hdr->capacity) ||
+        hdr->count > hdr->capacity) {
+        munmap(base, (size_t)st.st_size);
+        return -1;
+    }
+
+    hdr->source_name[MC_MAX_SOURCE - 1] = '\0';
+    hdr->symbol[MC_MAX_SYMBOL - 1] = '\0';
+    hdr->display_name[MC_MAX_NAME - 1] = '\0';
+    hdr->currency[MC_MAX_SYMBOL - 1] = '\0';
+
+    seg->hdr = hdr;
+    seg->recs = (tick_rec_t *)((char *)base + TICKS_HEADER_SIZE);
+    return 0;
+}
+
+static void load_series_dir(mc_ticks_t *ts, const char *dir)
+{
+    DIR *d = opendir(dir);
+    if (!d) return;
+
+    struct dirent *de;
+    while ((de = readdir(d)) != NULL) {
+        unsigned seq;
+        char tail;
+        if (sscanf(de->d_name, "%u.se%c", &seq, &tail) != 2 || tail != 'g')
+            continue;
+
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s", dir, de->d_name);
+
+        segment_t seg = { .seq = seq };
+        int rc = segment_load(path, &seg);
+        if (rc == -2) {
+            /* Older records cannot be read in place; the ticks are
+               short-lived, so drop them rather than convert */
+            MC_LOG_INFO("Removing tick segment %s of an older format", path);
+            unlink(path);
+            continue;
+        }
+        if (rc != 0) {
+            MC_LOG_WARN("Skipping invalid tick segment %s", path);
+            continue;
+        }
+
+        series_t *s = series_find(ts, seg.hdr->source_name, seg.hdr->symbol);
+        if (!s) s = series_add(ts, seg.hdr->source_name, seg.hdr->symbol, dir);
+        if (!s || series_push_segment(s, &seg) != 0)
+            segment_unmap(&seg);
+    }
+    closedir(d);
+}
+
+mc_ticks_t *mc_ticks_open(const char *dir)
+{
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        MC_LOG_ERROR("Tick store %s: %s", dir, strerror(errno));
+        return NULL;
+    }
+
+    mc_ticks_t *ts = calloc(1, sizeof(*ts));
+    if (!ts) return NULL;
+    ts->dir = strdup(dir);
+    if (!ts->dir) {
+        free(ts);
+        return NULL;
+    }
+    pthread_rwlock_init(&ts->lock, NULL);
+
+    DIR *d = opendir(dir);
+    if (d) {
+        struct dirent *de;
+        while ((de = readdir(d)) != NULL) {
+            if (de->d_name[0] == '.') continue;
+            char path[1024];
+            snprintf(path, sizeof(path), "%s/%s", dir, de->d_name);
+            load_series_dir(ts, path);
+        }
+        closedir(d);
+    }
+
+    int segs = 0;
+    for (int i = 0; i < ts->series_count; i++)
+        segs += ts->series[i]->seg_count;
+    MC_LOG_INFO("Tick store opened: %s (%d series, %d segments)",
+                dir, ts->series_count, segs);
+    return ts;
+}
+
+void mc_ticks_close(mc_ticks_t *ts)
+{
+    if (!ts) return;
+
+    for (int i = 0; i < ts->series_count; i++) {
+        series_t *s = ts->series[i];
+        for (int j = 0; j < s->seg_count; j++)
+            segment_unmap(&s->segs[j]);
+        free(s->segs);
+        free(s->dir);
+        free(s);
+    }
+    free(ts->series);
+    free(ts->index);
+    pthread_rwlock_destroy(&ts->lock);
+    free(ts->dir);
+    free(ts);
+}
+
+static series_t *series_create(mc_ticks_t *ts, const char *source, const char *symbol)
+{
+    char esc_source[MC_MAX_SOURCE * 3 + 1];
+    char esc_symbol[MC_MAX_SYMBOL * 3 + 1];
+    escape_name(source, esc_source, sizeof(esc_source));
+    escape_name(symbol, esc_symbol, sizeof(esc_symbol));
+
+    char dir[1024];
+    snprintf(dir, sizeof(dir), "%s/%s@%s", ts->dir, esc_source, esc_symbol);
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        MC_LOG_ERROR("Tick series %s: %s", dir, strerror(errno));
+        return NULL;
+    }
+    return series_add(ts, source, symbol, dir);
+}
+
+mc_error_t mc_ticks_append(mc_ticks_t *ts, const mc_data_entry_t *e)
+{
+    mc_error_t err = MC_OK;
+    pthread_rwlock_wrlock(&ts->lock);
+
+    series_t *s = series_find(ts, e->source_name, e->symbol);
+    if (!s) s = series_create(ts, e->source_name, e->symbol);
+
+    segment_t *seg = NULL;
+    if (s) {
+        seg = s->seg_count ? &s->segs[s->seg_count - 1] : NULL;
+        if (!seg || seg->hdr->count == seg->hdr->capacity ||
+            (seg->hdr->count > 0 &&
+             e->timestamp >= seg->hdr->first_ts + TICKS_SEG_SPAN_SEC))
+            seg = segment_create(s, e);
+    }
+
+    if (seg) {
+        seg_header_t *hdr = seg->hdr;
+        tick_rec_t *r = &seg->recs[hdr->count];
+        r->timestamp = e->timestamp;
+        r->fetched_at = e->fetched_at;
+        r->value = e->value;
+        r->change_pct = e->change_pct;
+        r->volume = e->volume;
+        if (hdr->count == 0) hdr->first_ts = e->timestamp;
+        hdr->last_ts = e->timestamp;
+        hdr->count++;
+    } else {
+        err = MC_ERR_IO;
+    }
+
+    pthread_rwlock_unlock(&ts->lock);
+    return err;
+}
+
+/* Read position walking one series backwards through its segments */
+typedef struct {
+    const series_t *s;
+    int             seg;
+    int             rec;
+} cursor_t;
+
+static void cursor_settle(cursor_t *c)
+{
+    while (c->seg >= 0 && c->rec < 0) {
+        if (--c->seg >= 0)
+            c->rec = (int)c->s->segs[c->seg].hdr->count - 1;
+    }
+}
+
+int mc_ticks_history(mc_ticks_t *ts, const char *symbol,
+                     mc_data_entry_t *out, int max_count)
+{
+    pthread_rwlock_rdlock(&ts->lock);
+
+    int ncur = 0;
+    for (int i = 0; i < ts->series_count; i++)
+        if (strcmp(ts->series[i]->symbol, symbol) == 0) ncur++;
+
+    cursor_t *cur = ncur ? malloc((size_t)ncur * sizeof(*cur)) : NULL;
+    ncur = 0;
+    for (int i = 0; cur && i < ts->series_count; i++) {
+        const series_t *s = ts->series[i];
+        if (strcmp(s->symbol, symbol) != 0 || s->seg_count == 0) continue;
+        cursor_t c = { s, s->seg_count - 1,
+                       (int)s->segs[s->seg_count - 1].hdr->count - 1 };
+        cursor_settle(&c);
+        if (c.seg >= 0) cur[ncur++] = c;
+    }
+
+    /* k-way merge, newest first; k is the handful of sources per symbol */
+    int count = 0;
+    while (count < max_count && ncur > 0) {
+        int best = 0;
+        for (int i = 1; i < ncur; i++)
+            if (cur[i].s->segs[cur[i].seg].recs[cur[i].rec].timestamp >
+                cur[best].s->segs[cur[best].seg].recs[cur[best].rec].timestamp)
+                best = i;
+
+        cursor_t *c = &cur[best];
+        const seg_header_t *hdr = c->s->segs[c->seg].hdr;
+        const tick_rec_t *r = &c->s->segs[c->seg].recs[c->rec];
+
+        mc_data_entry_t *e = &out[count++];
+        memset(e, 0, sizeof(*e));
+        memcpy(e->source_name, hdr->source_name, MC_MAX_SOURCE);
+        memcpy(e->symbol, hdr->symbol, MC_MAX_SYMBOL);
+        memcpy(e->display_name, hdr->display_name, MC_MAX_NAME);
+        memcpy(e->currency, hdr->currency, MC_MAX_SYMBOL);
+        e->source_type = hdr->source_type;
+        e->category = hdr->category;
+        e->value = r->value;
+        e->change_pct = r->change_pct;
+        e->volume = r->volume;
+        e->timestamp = r->timestamp;
+        e->fetched_at = r->fetched_at;
+
+        c->rec--;
+        cursor_settle(c);
+        if (c->seg < 0) cur[best] = cur[--ncur];
+    }
+
+    pthread_rwlock_unlock(&ts->lock);
+    free(cur);
+    return count;
+}
+
+int mc_ticks_prune(mc_ticks_t *ts, time_t cutoff)
+{
+    int dropped = 0;
+    pthread_rwlock_wrlock(&ts->lock);
+
+    for (int i = 0; i < ts->series_count; i++) {
+        series_t *s = ts->series[i];
+        int keep = 0;
+        while (keep < s->seg_count && s->segs[keep].hdr->last_ts < cutoff)
+            keep++;
+        if (keep == 0) continue;
+
+        for (int j = 0; j < keep; j++) {
+            char path[1024];
+            segment_path(s, s->segs[j].seq, path, sizeof(path));
+            segment_unmap(&s->segs[j]);
+            if (unlink(path) != 0)
+                MC_LOG_WARN("Remove tick segment %s: %s", path, strerror(errno));
+        }
+        memmove(s->segs, s->segs + keep,
+                (size_t)(s->seg_count - keep) * sizeof(*s->segs));
+        s->seg_count -= keep;
+        dropped += keep;
+    }
+
+    pthread_rwlock_unlock(&ts->lock);
+    return dropped;
+}